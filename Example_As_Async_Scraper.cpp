@@ -0,0 +1,87 @@
+#include <fstream>
+#include <filesystem>
+#include <set>
+#include "GigaWeb.hpp"
+#include "GigaAsync.hpp"
+GigaWeb *giga = new GigaWeb();
+/*
+An example of the recursive scraper written with coroutines (Linux, epoll).
+// g++ -std=c++20 ./Example_As_Async_Scraper.cpp -lgumbo -lcurl -o GigaAsync && ./GigaAsync
+*/
+
+std::set<std::string> visitedUrls;
+size_t MaxUrls = 1000;
+int SavedText = 0;
+
+int countWords(const std::string &text)
+{
+    std::istringstream iss(text);
+    std::string word;
+    int count = 0;
+
+    while (iss >> word)
+        ++count;
+
+    return count;
+}
+
+void saveToFile(const std::string &text)
+{
+    std::string cleaned = giga->cleanTXT(text);
+    if (cleaned.empty())
+        return;
+
+    std::ofstream outFile("TXT/async.txt", std::ios::app);
+    outFile << cleaned << "\n";
+    SavedText++;
+}
+
+GigaTask<void> Recursive(GigaLoop &loop, std::string url)
+{
+    FetchResult result = co_await loop.fetch(url);
+    if (!result.success)
+        co_return;
+
+    printf("\n%s\n", result.url.c_str());
+
+    GigaWeb::Document page(result.content);
+    for (const auto &next : page.links())
+    {
+        if (visitedUrls.size() < MaxUrls && visitedUrls.insert(next).second)
+            loop.spawn(Recursive(loop, next));
+    }
+
+    std::vector<std::string> contents = page.multipleContents();
+    std::string TextToSave;
+
+    for (const auto &ContentToSave : contents)
+    {
+        if (!ContentToSave.empty() && countWords(ContentToSave) > 10)
+        {
+            TextToSave.append(ContentToSave);
+        }
+    }
+
+    if (contents.empty())
+    {
+        TextToSave.append(page.mainContent());
+    }
+
+    saveToFile(TextToSave);
+}
+
+int main()
+{
+    std::filesystem::create_directories("TXT");
+
+    giga->fetcher.setMaxInFlight(256);
+    GigaLoop loop(giga->fetcher);
+
+    std::string initURL = "https://docs.python.org/pl/3/whatsnew/3.11.html";
+    visitedUrls.insert(initURL);
+    loop.spawn(Recursive(loop, initURL));
+    loop.run();
+
+    printf("Saved %d\n", SavedText);
+    return 0;
+}
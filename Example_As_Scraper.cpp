@@ -12,7 +12,6 @@ U can use this command for compile code with g++
 */
 
 // An example of how to use GigaWeb as a recursive scraper
-std::set<std::string> queueUrls;
 std::set<std::string> visitedUrls;
 
 std::string FileName;
@@ -121,22 +120,18 @@ float getFolderSizeInMB(const std::string &folderPath)
     }
 }
 
-void CollectUrl(std::string &html)
+void CollectUrl(const std::vector<std::string> &newUrls)
 {
-    std::vector<std::string> newUrls = giga->extractURLs(html);
     CountOfUrl = 0;
-    if (queueUrls.size() > 100)
+    if (giga->scheduler.size() > 100)
         return;
 
     for (const auto &url : newUrls)
     {
-        if (visitedUrls.find(url) == visitedUrls.end())
+        if (visitedUrls.insert(url).second)
         {
-            auto result = queueUrls.insert(url);
-            if (result.second)
-            {
-                ++CountOfUrl;
-            }
+            giga->scheduler.push(url);
+            ++CountOfUrl;
         }
     }
 }
@@ -153,25 +148,6 @@ int countWords(const std::string &text)
     return count;
 }
 
-std::string getLastElement()
-{
-    if (queueUrls.empty())
-    {
-        return "queueUrls.empty";
-    }
-    return *(--queueUrls.end());
-}
-
-void removeLastElement()
-{
-    if (queueUrls.empty())
-    {
-        std::cout << "queueUrls.empty" << std::endl;
-        return;
-    }
-    queueUrls.erase(--queueUrls.end());
-}
-
 void Stats()
 {
     printf("queue %ld \t"
@@ -179,7 +155,7 @@ void Stats()
            "Saved %d \t"
            "File %s | Size %.4f \t"
            "File name %s\n",
-           queueUrls.size(),
+           giga->scheduler.size(),
            getFolderSizeInMB("TXT"),
            SavedText,
            FileName.c_str(),
@@ -214,24 +190,15 @@ std::string saveToFile(std::string text)
 
 void Recursive()
 {
-    while (!queueUrls.empty())
-    {
-        auto it_last = --queueUrls.end();
-        std::string Last = *it_last;
-        queueUrls.erase(it_last);
-
-        if (visitedUrls.find(Last) != visitedUrls.end())
-        {
-            printf("\nSkipping because URL is in visited_list\n");
-            continue;
-        }
-
-        std::string content = "";
-        if (giga && giga->fetchWebContent(Last, content))
+    giga->crawl([](FetchResult &result)
+                {
+        if (result.success)
         {
-            CollectUrl(content);
+            printf("\n%s\n", result.url.c_str());
+            GigaWeb::Document page(result.content);
+            CollectUrl(page.links());
 
-            std::vector<std::string> contents = giga->getMultipleContents(content);
+            std::vector<std::string> contents = page.multipleContents();
             std::string TextToSave;
 
             for (const auto &ContentToSave : contents)
@@ -244,28 +211,29 @@ void Recursive()
 
             if (contents.empty())
             {
-                TextToSave.append(giga->getMainContent(content));
+                TextToSave.append(page.mainContent());
             }
 
-            visitedUrls.insert(Last);
-
             saveToFile(TextToSave.c_str());
-        }
-        else
-        {
-            visitedUrls.insert(Last);
-        }
-    }
+        } });
 }
 
 int main()
 {
     createDir("TXT");
     clearScreen();
+
+    FetchFilter filter;
+    filter.maxBodySize = 8 * 1024 * 1024;
+    giga->fetcher.setFilter(filter);
+    giga->fetcher.enableCache("cache");
+
     std::string initHTML;
-    if (giga->fetchWebContent("https://docs.python.org/pl/3/whatsnew/3.11.html", initHTML))
+    std::string initURL = "https://docs.python.org/pl/3/whatsnew/3.11.html";
+    visitedUrls.insert(initURL);
+    if (giga->fetchWebContent(initURL, initHTML))
     {
-        CollectUrl(initHTML);
+        CollectUrl(giga->extractURLs(initHTML));
         Recursive();
     }
 
@@ -0,0 +1,199 @@
+#pragma once
+#include <cstddef>
+#include <cstdlib>
+#include <vector>
+#include <gumbo.h>
+
+// Bump allocators for Gumbo parses. Every node, attribute and string of a
+// parse comes out of a few large blocks owned by that parse (a
+// GigaArena::Parse); deallocation is a no-op and the blocks go back to the
+// arena when the parse is destroyed. The arena keeps returned blocks for the
+// next documents up to maxRetained bytes, so a long-lived document only pins
+// its own blocks and never stops the others from being reused.
+//
+// An arena is not thread-safe: use GigaArena::local() and destroy a parse on
+// the thread that created it.
+class GigaArena
+{
+    struct Block
+    {
+        char *data;
+        size_t size;
+    };
+
+public:
+    static constexpr size_t kDefaultBlockSize = 256 * 1024;
+    static constexpr size_t kDefaultMaxRetained = 16 * 1024 * 1024;
+
+    // The allocations of one parse. Pass options() to
+    // gumbo_parse_with_options and keep the Parse (at a stable address)
+    // for as long as the GumboOutput is used.
+    class Parse
+    {
+    public:
+        explicit Parse(GigaArena &arena) : arena(arena)
+        {
+        }
+
+        ~Parse()
+        {
+            for (const Block &block : blocks)
+                arena.recycle(block);
+            arena.used -= used;
+        }
+
+        Parse(const Parse &) = delete;
+        Parse &operator=(const Parse &) = delete;
+
+        GumboOptions options()
+        {
+            GumboOptions options = kGumboDefaultOptions;
+            options.allocator = Allocate;
+            options.deallocator = Deallocate;
+            options.userdata = this;
+            return options;
+        }
+
+        void *allocate(size_t size)
+        {
+            size = (size + kAlignment - 1) & ~(kAlignment - 1);
+            if (size == 0)
+                size = kAlignment;
+
+            if (blocks.empty() || blocks.back().size - offset < size)
+            {
+                Block block = arena.take(size);
+                if (!block.data)
+                    return nullptr;
+                blocks.push_back(block);
+                offset = 0;
+            }
+            void *result = blocks.back().data + offset;
+            offset += size;
+            used += size;
+            arena.used += size;
+            return result;
+        }
+
+        // Bytes handed out to this parse.
+        size_t bytesUsed() const
+        {
+            return used;
+        }
+
+    private:
+        GigaArena &arena;
+        std::vector<Block> blocks;
+        size_t offset = 0;
+        size_t used = 0;
+
+        static void *Allocate(void *userdata, size_t size)
+        {
+            return static_cast<Parse *>(userdata)->allocate(size);
+        }
+
+        static void Deallocate(void *, void *)
+        {
+        }
+    };
+
+    explicit GigaArena(size_t blockSize = kDefaultBlockSize, size_t maxRetained = kDefaultMaxRetained)
+        : blockSize(blockSize ? blockSize : kDefaultBlockSize), maxRetained(maxRetained)
+    {
+    }
+
+    // Parses must not outlive their arena.
+    ~GigaArena()
+    {
+        for (const Block &block : spare)
+            std::free(block.data);
+    }
+
+    GigaArena(const GigaArena &) = delete;
+    GigaArena &operator=(const GigaArena &) = delete;
+
+    static GigaArena &local()
+    {
+        thread_local GigaArena arena;
+        return arena;
+    }
+
+    // Also frees spare blocks beyond the new limit.
+    void setMaxRetained(size_t bytes)
+    {
+        maxRetained = bytes;
+        trim();
+    }
+
+    size_t getMaxRetained() const
+    {
+        return maxRetained;
+    }
+
+    // Bytes handed out to the parses still alive.
+    size_t bytesUsed() const
+    {
+        return used;
+    }
+
+    // Bytes held from the system, in use by parses or kept for reuse.
+    size_t bytesReserved() const
+    {
+        return reserved;
+    }
+
+private:
+    static constexpr size_t kAlignment = alignof(std::max_align_t);
+
+    std::vector<Block> spare;
+    size_t spareBytes = 0;
+    size_t reserved = 0;
+    size_t used = 0;
+    size_t blockSize;
+    size_t maxRetained;
+
+    // A spare block of at least size bytes, or a new one.
+    Block take(size_t size)
+    {
+        for (size_t i = spare.size(); i-- > 0;)
+        {
+            if (spare[i].size >= size)
+            {
+                Block block = spare[i];
+                spare.erase(spare.begin() + static_cast<std::ptrdiff_t>(i));
+                spareBytes -= block.size;
+                return block;
+            }
+        }
+
+        size_t capacity = size > blockSize ? size : blockSize;
+        Block block{static_cast<char *>(std::malloc(capacity)), capacity};
+        if (block.data)
+            reserved += capacity;
+        return block;
+    }
+
+    void recycle(const Block &block)
+    {
+        if (spareBytes + block.size <= maxRetained)
+        {
+            spare.push_back(block);
+            spareBytes += block.size;
+            return;
+        }
+        reserved -= block.size;
+        std::free(block.data);
+    }
+
+    void trim()
+    {
+        while (spareBytes > maxRetained)
+        {
+            const Block &block = spare.back();
+            spareBytes -= block.size;
+            reserved -= block.size;
+            std::free(block.data);
+            spare.pop_back();
+        }
+    }
+};
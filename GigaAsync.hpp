@@ -0,0 +1,330 @@
+#pragma once
+#include <cerrno>
+#include <chrono>
+#include <coroutine>
+#include <algorithm>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <sys/epoll.h>
+#include <unistd.h>
+#include "GigaFetcher.hpp"
+
+template <typename T>
+struct GigaTaskResult
+{
+    std::optional<T> value;
+
+    void return_value(T result)
+    {
+        value = std::move(result);
+    }
+
+    T take()
+    {
+        return std::move(*value);
+    }
+};
+
+template <>
+struct GigaTaskResult<void>
+{
+    void return_void() {}
+    void take() {}
+};
+
+// Lazily started coroutine; co_await on it runs it and resumes the awaiting
+// coroutine when it finishes.
+template <typename T = void>
+class GigaTask
+{
+public:
+    struct promise_type : GigaTaskResult<T>
+    {
+        std::coroutine_handle<> continuation;
+        std::exception_ptr exception;
+
+        GigaTask get_return_object()
+        {
+            return GigaTask(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() noexcept
+        {
+            return {};
+        }
+
+        auto final_suspend() noexcept
+        {
+            struct FinalAwaiter
+            {
+                bool await_ready() noexcept { return false; }
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept
+                {
+                    std::coroutine_handle<> next = handle.promise().continuation;
+                    return next ? next : std::noop_coroutine();
+                }
+                void await_resume() noexcept {}
+            };
+            return FinalAwaiter{};
+        }
+
+        void unhandled_exception()
+        {
+            exception = std::current_exception();
+        }
+    };
+
+    explicit GigaTask(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+
+    GigaTask(GigaTask &&other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+
+    GigaTask &operator=(GigaTask &&other) noexcept
+    {
+        if (this != &other)
+        {
+            if (handle)
+                handle.destroy();
+            handle = std::exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+
+    GigaTask(const GigaTask &) = delete;
+    GigaTask &operator=(const GigaTask &) = delete;
+
+    ~GigaTask()
+    {
+        if (handle)
+            handle.destroy();
+    }
+
+    bool await_ready() const noexcept
+    {
+        return !handle || handle.done();
+    }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+    {
+        handle.promise().continuation = awaiting;
+        return handle;
+    }
+
+    T await_resume()
+    {
+        if (handle.promise().exception)
+            std::rethrow_exception(handle.promise().exception);
+        return handle.promise().take();
+    }
+
+private:
+    std::coroutine_handle<promise_type> handle;
+};
+
+// Single-threaded executor: resumes ready coroutines and drives the fetcher's
+// curl_multi sockets with epoll. Run one loop (with its own GigaFetcher) per
+// thread; fetchers may share a GigaShare.
+class GigaLoop
+{
+public:
+    class FetchAwaitable
+    {
+    public:
+        FetchAwaitable(GigaLoop &loop, std::string url) : loop(loop), url(std::move(url)) {}
+
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> awaiting)
+        {
+            loop.fetcher.submit(url, [this, awaiting](FetchResult &finished)
+                                {
+                                    result = std::move(finished);
+                                    loop.ready.push_back(awaiting); });
+            loop.kick = true;
+        }
+
+        FetchResult await_resume()
+        {
+            return std::move(result);
+        }
+
+    private:
+        GigaLoop &loop;
+        std::string url;
+        FetchResult result;
+    };
+
+    explicit GigaLoop(GigaFetcher &fetcher) : fetcher(fetcher)
+    {
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        fetcher.setSocketCallbacks(SocketCallback, TimerCallback, this);
+    }
+
+    ~GigaLoop()
+    {
+        fetcher.setSocketCallbacks(nullptr, nullptr, nullptr);
+        if (epollFd >= 0)
+            close(epollFd);
+    }
+
+    GigaLoop(const GigaLoop &) = delete;
+    GigaLoop &operator=(const GigaLoop &) = delete;
+
+    FetchAwaitable fetch(const std::string &url)
+    {
+        return FetchAwaitable(*this, url);
+    }
+
+    // Starts task on the next loop iteration; the loop owns it until it finishes.
+    void spawn(GigaTask<void> task)
+    {
+        ++liveTasks;
+        ready.push_back(detach(std::move(task)).handle);
+    }
+
+    size_t tasks() const
+    {
+        return liveTasks;
+    }
+
+    // Runs until every spawned task has finished and no transfer is left.
+    void run()
+    {
+        epoll_event events[64];
+        while (liveTasks > 0 || fetcher.pending() > 0)
+        {
+            while (!ready.empty())
+            {
+                std::coroutine_handle<> next = ready.front();
+                ready.pop_front();
+                next.resume();
+            }
+
+            if (kick)
+            {
+                kick = false;
+                fetcher.socketAction(CURL_SOCKET_TIMEOUT, 0);
+                continue;
+            }
+
+            if (liveTasks == 0 && fetcher.pending() == 0)
+                break;
+
+            int waitMs = 1000;
+            if (hasDeadline)
+            {
+                auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+                waitMs = static_cast<int>(std::max<std::chrono::milliseconds::rep>(left.count(), 0));
+            }
+
+            int count = epoll_wait(epollFd, events, 64, waitMs);
+            if (count < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                std::cerr << "epoll_wait failed" << std::endl;
+                break;
+            }
+
+            if (count == 0)
+            {
+                if (hasDeadline)
+                {
+                    hasDeadline = false;
+                    fetcher.socketAction(CURL_SOCKET_TIMEOUT, 0);
+                }
+                continue;
+            }
+
+            for (int i = 0; i < count; ++i)
+            {
+                int flags = 0;
+                if (events[i].events & EPOLLIN)
+                    flags |= CURL_CSELECT_IN;
+                if (events[i].events & EPOLLOUT)
+                    flags |= CURL_CSELECT_OUT;
+                if (events[i].events & (EPOLLERR | EPOLLHUP))
+                    flags |= CURL_CSELECT_ERR;
+                fetcher.socketAction(events[i].data.fd, flags);
+            }
+        }
+    }
+
+private:
+    struct Detached
+    {
+        struct promise_type
+        {
+            Detached get_return_object()
+            {
+                return Detached{std::coroutine_handle<promise_type>::from_promise(*this)};
+            }
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            std::suspend_never final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception() { std::terminate(); }
+        };
+
+        std::coroutine_handle<promise_type> handle;
+    };
+
+    GigaFetcher &fetcher;
+    int epollFd = -1;
+    std::chrono::steady_clock::time_point deadline;
+    bool hasDeadline = false;
+    bool kick = false;
+    size_t liveTasks = 0;
+    std::deque<std::coroutine_handle<>> ready;
+    std::unordered_set<curl_socket_t> watched;
+
+    Detached detach(GigaTask<void> task)
+    {
+        try
+        {
+            co_await task;
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "GigaLoop task failed: " << e.what() << std::endl;
+        }
+        --liveTasks;
+    }
+
+    static int SocketCallback(CURL *, curl_socket_t socket, int what, void *userp, void *)
+    {
+        GigaLoop *loop = static_cast<GigaLoop *>(userp);
+        if (what == CURL_POLL_REMOVE)
+        {
+            epoll_ctl(loop->epollFd, EPOLL_CTL_DEL, socket, nullptr);
+            loop->watched.erase(socket);
+            return 0;
+        }
+
+        epoll_event event{};
+        event.data.fd = socket;
+        if (what & CURL_POLL_IN)
+            event.events |= EPOLLIN;
+        if (what & CURL_POLL_OUT)
+            event.events |= EPOLLOUT;
+
+        int op = loop->watched.insert(socket).second ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
+        epoll_ctl(loop->epollFd, op, socket, &event);
+        return 0;
+    }
+
+    static int TimerCallback(CURLM *, long timeout, void *userp)
+    {
+        GigaLoop *loop = static_cast<GigaLoop *>(userp);
+        loop->hasDeadline = timeout >= 0;
+        if (loop->hasDeadline)
+            loop->deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+        return 0;
+    }
+};
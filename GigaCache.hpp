@@ -0,0 +1,185 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+struct CacheEntry
+{
+    std::string url;
+    std::string etag;
+    std::string lastModified;
+    std::string contentType;
+    long httpCode = 200;
+    std::string body;
+};
+
+// Persistent response cache: one file per normalized URL holding the body and
+// the validators needed for a conditional request (If-None-Match / If-Modified-Since).
+class GigaCache
+{
+public:
+    explicit GigaCache(const std::filesystem::path &directory) : directory(directory)
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(directory, ec);
+    }
+
+    const std::filesystem::path &getDirectory() const
+    {
+        return directory;
+    }
+
+    // Lowercases scheme and host, drops the fragment and a default port, and
+    // makes an empty path "/".
+    static std::string normalizeURL(const std::string &url)
+    {
+        std::string normalized = url.substr(0, url.find('#'));
+
+        size_t schemeEnd = normalized.find("://");
+        if (schemeEnd == std::string::npos)
+            return normalized;
+
+        size_t hostStart = schemeEnd + 3;
+        size_t hostEnd = normalized.find_first_of("/?", hostStart);
+        if (hostEnd == std::string::npos)
+            hostEnd = normalized.size();
+
+        std::string scheme = normalized.substr(0, schemeEnd);
+        std::string host = normalized.substr(hostStart, hostEnd - hostStart);
+        std::string rest = normalized.substr(hostEnd);
+        auto lower = [](std::string &text)
+        { std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c)
+                         { return std::tolower(c); }); };
+        lower(scheme);
+        lower(host);
+
+        if ((scheme == "http" && host.size() > 3 && host.compare(host.size() - 3, 3, ":80") == 0))
+            host.resize(host.size() - 3);
+        else if (scheme == "https" && host.size() > 4 && host.compare(host.size() - 4, 4, ":443") == 0)
+            host.resize(host.size() - 4);
+
+        if (rest.empty() || rest[0] == '?')
+            rest.insert(0, "/");
+
+        return scheme + "://" + host + rest;
+    }
+
+    bool load(const std::string &url, CacheEntry &entry) const
+    {
+        std::string key = normalizeURL(url);
+        std::ifstream file(pathFor(key), std::ios::binary);
+        if (!file)
+            return false;
+
+        std::string magic;
+        if (!std::getline(file, magic) || magic != fileMagic)
+            return false;
+
+        CacheEntry loaded;
+        std::string line;
+        while (std::getline(file, line) && !line.empty())
+        {
+            size_t colon = line.find(':');
+            if (colon == std::string::npos)
+                return false;
+            std::string name = line.substr(0, colon);
+            std::string value = line.substr(colon + 1);
+            if (name == "url")
+                loaded.url = value;
+            else if (name == "etag")
+                loaded.etag = value;
+            else if (name == "last-modified")
+                loaded.lastModified = value;
+            else if (name == "content-type")
+                loaded.contentType = value;
+            else if (name == "status")
+                loaded.httpCode = std::strtol(value.c_str(), nullptr, 10);
+        }
+
+        if (loaded.url != key)
+            return false;
+
+        loaded.body.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        entry = std::move(loaded);
+        return true;
+    }
+
+    bool store(const CacheEntry &entry)
+    {
+        std::string key = normalizeURL(entry.url);
+        std::filesystem::path target = pathFor(key);
+        std::filesystem::path temp = target;
+        temp += uniqueSuffix();
+
+        std::error_code ec;
+        {
+            std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+            if (!file)
+                return false;
+
+            file << fileMagic << "\n"
+                 << "url:" << key << "\n"
+                 << "etag:" << entry.etag << "\n"
+                 << "last-modified:" << entry.lastModified << "\n"
+                 << "content-type:" << entry.contentType << "\n"
+                 << "status:" << entry.httpCode << "\n\n";
+            file.write(entry.body.data(), static_cast<std::streamsize>(entry.body.size()));
+            file.close();
+            if (!file)
+            {
+                std::filesystem::remove(temp, ec);
+                return false;
+            }
+        }
+
+        std::filesystem::rename(temp, target, ec);
+        if (ec)
+            std::filesystem::remove(temp, ec);
+        return !ec;
+    }
+
+    void erase(const std::string &url)
+    {
+        std::error_code ec;
+        std::filesystem::remove(pathFor(normalizeURL(url)), ec);
+    }
+
+private:
+    static constexpr const char *fileMagic = "GIGACACHE1";
+
+    // Temp file name private to this writer (process, thread and call), so
+    // concurrent stores of one URL never write into the same file; the
+    // last rename wins with a complete entry.
+    static std::string uniqueSuffix()
+    {
+        static std::atomic<uint64_t> counter{0};
+        return "." + std::to_string(getpid()) + "." +
+               std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + "." +
+               std::to_string(counter.fetch_add(1, std::memory_order_relaxed)) + ".tmp";
+    }
+
+    std::filesystem::path directory;
+
+    std::filesystem::path pathFor(const std::string &key) const
+    {
+        uint64_t hash = 1469598103934665603ULL;
+        for (unsigned char c : key)
+        {
+            hash ^= c;
+            hash *= 1099511628211ULL;
+        }
+
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.cache", static_cast<unsigned long long>(hash));
+        return directory / name;
+    }
+};
@@ -0,0 +1,15 @@
+#pragma once
+#include <curl/curl.h>
+
+// Process-wide libcurl initialisation shared by GigaFetcher and GigaShare.
+// curl_global_init runs once, on first use, and curl_global_cleanup only at
+// exit, so no object's lifetime can tear libcurl down under another.
+inline void gigaCurlGlobalInit()
+{
+    struct CurlGlobal
+    {
+        CurlGlobal() { curl_global_init(CURL_GLOBAL_DEFAULT); }
+        ~CurlGlobal() { curl_global_cleanup(); }
+    };
+    static CurlGlobal global;
+}
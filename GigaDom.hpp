@@ -0,0 +1,337 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <strings.h>
+#include <gumbo.h>
+
+// Text reference of the flat DOM: a range of the source buffer, or of the
+// DOM's own pool when the text differs from the source (decoded entities,
+// lowercased attribute names, nodes synthesized by the parser).
+struct DomString
+{
+    static constexpr uint32_t kPooled = 0x80000000u;
+
+    uint32_t offset = 0;
+    uint32_t length = 0;
+};
+
+struct DomAttribute
+{
+    DomString name;
+    DomString value;
+};
+
+// One node of the flat DOM. Nodes are stored in preorder, so the subtree of
+// node i is the range [i, subtreeEnd) and skipping it is a single jump.
+struct DomNode
+{
+    static constexpr uint32_t kNone = 0xFFFFFFFFu;
+
+    uint32_t parent = kNone;
+    uint32_t firstChild = kNone;
+    uint32_t nextSibling = kNone;
+    uint32_t subtreeEnd = 0;
+    uint16_t tag = GUMBO_TAG_UNKNOWN;
+    uint8_t type = GUMBO_NODE_DOCUMENT;
+    DomString text; // text, comment and CDATA nodes; tag name of unknown elements
+    uint32_t firstAttribute = 0;
+    uint32_t attributeCount = 0;
+};
+
+// Contiguous, preorder DOM. It is built either from a Gumbo parse
+// (fromGumbo) or incrementally by a tokenizer through beginElement /
+// addAttribute / addNode / endElement. The source buffer must outlive it.
+class FlatDom
+{
+public:
+    // DomString offsets have 31 bits (the top one tells pool from source), so
+    // larger sources get a DOM holding only the document node.
+    static constexpr size_t kMaxSource = DomString::kPooled - 1;
+
+    FlatDom() = default;
+
+    explicit FlatDom(std::string_view source) : source(source)
+    {
+        DomNode document;
+        document.type = GUMBO_NODE_DOCUMENT;
+        nodes.push_back(document);
+        open.push_back({0, DomNode::kNone});
+    }
+
+    static FlatDom fromGumbo(const GumboOutput *output, std::string_view source)
+    {
+        FlatDom dom(source);
+        if (!output || !output->document || !fits(source))
+        {
+            dom.finish();
+            return dom;
+        }
+
+        struct Frame
+        {
+            const GumboVector *children;
+            unsigned int next;
+            bool element;
+        };
+
+        // Reused across calls, so converting a page allocates no stack.
+        static thread_local std::vector<Frame> stack;
+        stack.clear();
+        stack.push_back({&output->document->v.document.children, 0, false});
+        while (!stack.empty())
+        {
+            Frame &frame = stack.back();
+            if (frame.next >= frame.children->length)
+            {
+                if (frame.element)
+                    dom.endElement();
+                stack.pop_back();
+                continue;
+            }
+
+            const GumboNode *node = static_cast<const GumboNode *>(frame.children->data[frame.next++]);
+            if (node->type == GUMBO_NODE_ELEMENT || node->type == GUMBO_NODE_TEMPLATE)
+            {
+                const GumboElement &element = node->v.element;
+                std::string_view name;
+                if (element.tag == GUMBO_TAG_UNKNOWN)
+                {
+                    GumboStringPiece original = element.original_tag;
+                    gumbo_tag_from_original_text(&original);
+                    name = std::string_view(original.data, original.length);
+                }
+                dom.beginElement(static_cast<GumboTag>(element.tag), name, static_cast<GumboNodeType>(node->type));
+
+                for (unsigned int i = 0; i < element.attributes.length; ++i)
+                {
+                    const GumboAttribute *attr = static_cast<const GumboAttribute *>(element.attributes.data[i]);
+                    GumboStringPiece value = attr->original_value;
+                    if (value.length >= 2 && (value.data[0] == '"' || value.data[0] == '\''))
+                    {
+                        ++value.data;
+                        value.length -= 2;
+                    }
+                    dom.addAttribute(dom.preferSource(attr->name, attr->original_name),
+                                     dom.preferSource(attr->value, value));
+                }
+
+                stack.push_back({&element.children, 0, true});
+            }
+            else
+            {
+                dom.addNode(static_cast<GumboNodeType>(node->type),
+                            dom.preferSource(node->v.text.text, node->v.text.original_text));
+            }
+        }
+
+        dom.finish();
+        return dom;
+    }
+
+    uint32_t beginElement(GumboTag tag, std::string_view name = {}, GumboNodeType type = GUMBO_NODE_ELEMENT)
+    {
+        uint32_t index = append(type);
+        DomNode &node = nodes[index];
+        node.tag = static_cast<uint16_t>(tag);
+        node.firstAttribute = static_cast<uint32_t>(attributes.size());
+        if (tag == GUMBO_TAG_UNKNOWN)
+            node.text = store(name);
+        open.push_back({index, DomNode::kNone});
+        return index;
+    }
+
+    // Adds an attribute to the element opened last; call before its children.
+    void addAttribute(std::string_view name, std::string_view value)
+    {
+        attributes.push_back({store(name), store(value)});
+        ++nodes[open.back().node].attributeCount;
+    }
+
+    void endElement()
+    {
+        if (open.size() <= 1)
+            return;
+        nodes[open.back().node].subtreeEnd = static_cast<uint32_t>(nodes.size());
+        open.pop_back();
+    }
+
+    uint32_t addNode(GumboNodeType type, std::string_view text)
+    {
+        uint32_t index = append(type);
+        nodes[index].text = store(text);
+        nodes[index].subtreeEnd = index + 1;
+        return index;
+    }
+
+    // Closes every element still open; the DOM is complete afterwards.
+    void finish()
+    {
+        while (open.size() > 1)
+            endElement();
+        if (!nodes.empty())
+            nodes[0].subtreeEnd = static_cast<uint32_t>(nodes.size());
+    }
+
+    size_t size() const
+    {
+        return nodes.size();
+    }
+
+    static bool fits(std::string_view source)
+    {
+        return source.size() <= kMaxSource;
+    }
+
+    bool empty() const
+    {
+        return nodes.empty();
+    }
+
+    const DomNode &operator[](uint32_t index) const
+    {
+        return nodes[index];
+    }
+
+    const std::vector<DomNode> &getNodes() const
+    {
+        return nodes;
+    }
+
+    std::string_view view(DomString text) const
+    {
+        if (text.offset & DomString::kPooled)
+            return std::string_view(pool).substr(text.offset & ~DomString::kPooled, text.length);
+        return source.substr(text.offset, text.length);
+    }
+
+    std::string_view text(uint32_t index) const
+    {
+        return view(nodes[index].text);
+    }
+
+    std::string_view tagName(uint32_t index) const
+    {
+        const DomNode &node = nodes[index];
+        if (node.type != GUMBO_NODE_ELEMENT && node.type != GUMBO_NODE_TEMPLATE)
+            return {};
+        if (node.tag == GUMBO_TAG_UNKNOWN)
+            return view(node.text);
+        return gumbo_normalized_tagname(static_cast<GumboTag>(node.tag));
+    }
+
+    const DomAttribute *attributesBegin(uint32_t index) const
+    {
+        return attributes.data() + nodes[index].firstAttribute;
+    }
+
+    const DomAttribute *attributesEnd(uint32_t index) const
+    {
+        return attributesBegin(index) + nodes[index].attributeCount;
+    }
+
+    // Attribute names compare case-insensitively, as in HTML.
+    bool attribute(uint32_t index, std::string_view name, std::string_view &value) const
+    {
+        for (const DomAttribute *attr = attributesBegin(index); attr != attributesEnd(index); ++attr)
+        {
+            std::string_view attrName = view(attr->name);
+            if (attrName.size() == name.size() && strncasecmp(attrName.data(), name.data(), name.size()) == 0)
+            {
+                value = view(attr->value);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Concatenated text of the subtree, in document order.
+    std::string textContent(uint32_t index) const
+    {
+        std::string content;
+        for (uint32_t i = index, end = nodes[index].subtreeEnd; i < end; ++i)
+        {
+            uint8_t type = nodes[i].type;
+            if (type == GUMBO_NODE_TEXT || type == GUMBO_NODE_WHITESPACE || type == GUMBO_NODE_CDATA)
+                content.append(text(i));
+        }
+        return content;
+    }
+
+    void clear()
+    {
+        nodes.clear();
+        attributes.clear();
+        pool.clear();
+        open.clear();
+    }
+
+private:
+    struct OpenElement
+    {
+        uint32_t node;
+        uint32_t lastChild;
+    };
+
+    std::string_view source;
+    std::vector<DomNode> nodes;
+    std::vector<DomAttribute> attributes;
+    std::string pool;
+    std::vector<OpenElement> open;
+
+    uint32_t append(GumboNodeType type)
+    {
+        uint32_t index = static_cast<uint32_t>(nodes.size());
+        DomNode node;
+        node.type = static_cast<uint8_t>(type);
+
+        OpenElement &parent = open.back();
+        node.parent = parent.node;
+        if (parent.lastChild == DomNode::kNone)
+            nodes[parent.node].firstChild = index;
+        else
+            nodes[parent.lastChild].nextSibling = index;
+        parent.lastChild = index;
+
+        nodes.push_back(node);
+        return index;
+    }
+
+    DomString store(std::string_view text)
+    {
+        DomString ref;
+        ref.length = static_cast<uint32_t>(text.size());
+        if (text.empty())
+            return ref;
+
+        const char *begin = source.data();
+        if (begin && text.data() >= begin && text.data() + text.size() <= begin + source.size())
+        {
+            ref.offset = static_cast<uint32_t>(text.data() - begin);
+            return ref;
+        }
+
+        if (pool.size() + text.size() > kMaxSource)
+        {
+            ref.length = 0;
+            return ref;
+        }
+        ref.offset = static_cast<uint32_t>(pool.size()) | DomString::kPooled;
+        pool.append(text);
+        return ref;
+    }
+
+    // The source range when it spells exactly the decoded text, so the DOM
+    // refers to the page instead of copying it.
+    std::string_view preferSource(const char *decoded, GumboStringPiece original) const
+    {
+        size_t length = std::strlen(decoded);
+        if (original.data && original.length == length && std::memcmp(original.data, decoded, length) == 0)
+            return std::string_view(original.data, original.length);
+        return std::string_view(decoded, length);
+    }
+};
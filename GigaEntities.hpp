@@ -0,0 +1,218 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "GigaScan.hpp"
+#include "knownEntities.hpp"
+
+// HTML5 character reference decoding in one pass with no allocation per
+// reference. Named references take the longest match, so the legacy names
+// that may omit ';' ("&amp", "&copy", ...) are recognised as the spec
+// requires; numeric references follow the spec's replacement rules.
+class GigaEntities
+{
+public:
+    // Appends text with every character reference decoded. In attribute
+    // values a legacy reference followed by '=' or an alphanumeric is left
+    // alone, as browsers do ("?a=1&copy=2").
+    static void decode(std::string_view text, std::string &out, bool attribute = false)
+    {
+        const char *p = text.data();
+        const char *end = p + text.size();
+        while (p < end)
+        {
+            const char *amp = GigaScan::find(p, end, '&');
+            out.append(p, amp);
+            if (amp == end)
+                return;
+            p = amp + 1 + decodeReference(std::string_view(amp + 1, static_cast<size_t>(end - amp - 1)), out, attribute);
+        }
+    }
+
+    // Decodes the reference after '&' into out and returns how many bytes of
+    // text it consumed; when text starts no reference a literal '&' is
+    // appended and 0 returned.
+    static size_t decodeReference(std::string_view text, std::string &out, bool attribute = false)
+    {
+        std::string_view named;
+        uint32_t code = 0;
+        size_t length = match(text, named, code, attribute);
+        if (!length)
+            out.push_back('&');
+        else if (!named.empty())
+            out.append(named);
+        else
+            appendUtf8(code, out);
+        return length;
+    }
+
+    // Length of the reference after '&', 0 when there is none. A named
+    // reference sets named to its UTF-8 value, a numeric one sets code.
+    static size_t match(std::string_view text, std::string_view &named, uint32_t &code, bool attribute = false)
+    {
+        named = {};
+        if (!text.empty() && text[0] == '#')
+            return matchNumeric(text, code);
+
+        size_t run = 0;
+        while (run < text.size() && run < kMaxName && isAlnum(text[run]))
+            ++run;
+        if (run == 0)
+            return 0;
+
+        if (run < text.size() && text[run] == ';' && find(text.substr(0, run + 1), named))
+            return run + 1;
+
+        for (size_t length = std::min(run, kMaxLegacyName); length > 0; --length)
+        {
+            if (!find(text.substr(0, length), named))
+                continue;
+            if (attribute && length < text.size() && (text[length] == '=' || isAlnum(text[length])))
+            {
+                named = {};
+                return 0;
+            }
+            return length;
+        }
+        return 0;
+    }
+
+    // Length of a "name;" reference after '&' whose name is known, 0 for
+    // anything else: the "&\w+;" forms removeHtmlEntities has always removed.
+    // Numeric references and legacy names without ';' do not count.
+    static size_t matchTerminated(std::string_view text)
+    {
+        size_t run = 0;
+        while (run < text.size() && run < kMaxName && isAlnum(text[run]))
+            ++run;
+        std::string_view named;
+        if (run == 0 || run >= text.size() || text[run] != ';' || !find(text.substr(0, run + 1), named))
+            return 0;
+        return run + 1;
+    }
+
+    static void appendUtf8(uint32_t code, std::string &out)
+    {
+        if (code < 0x80)
+        {
+            out.push_back(static_cast<char>(code));
+        }
+        else if (code < 0x800)
+        {
+            out.push_back(static_cast<char>(0xC0 | (code >> 6)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        }
+        else if (code < 0x10000)
+        {
+            out.push_back(static_cast<char>(0xE0 | (code >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        }
+        else
+        {
+            out.push_back(static_cast<char>(0xF0 | (code >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        }
+    }
+
+private:
+    // Longest name with ';' ("CounterClockwiseContourIntegral;") and the
+    // longest of the names allowed without it ("frac34", "middot").
+    static constexpr size_t kMaxName = 32;
+    static constexpr size_t kMaxLegacyName = 6;
+
+    // Start of each first-byte range of knownEntities (names without the
+    // '&'), computed at compile time, so a lookup is a short binary search
+    // over views instead of hashing a freshly built key.
+    struct Buckets
+    {
+        uint16_t first[257] = {};
+    };
+
+    static constexpr size_t kEntities = sizeof(knownEntities) / sizeof(knownEntities[0]);
+
+    static constexpr Buckets buildBuckets()
+    {
+        Buckets buckets;
+        size_t i = 0;
+        for (size_t c = 0; c <= 256; ++c)
+        {
+            while (i < kEntities && static_cast<unsigned char>(knownEntities[i].name[1]) < c)
+                ++i;
+            buckets.first[c] = static_cast<uint16_t>(i);
+        }
+        return buckets;
+    }
+
+    static constexpr bool isSorted()
+    {
+        for (size_t i = 1; i < kEntities; ++i)
+        {
+            if (!(knownEntities[i - 1].name < knownEntities[i].name))
+                return false;
+        }
+        return true;
+    }
+
+    static bool find(std::string_view name, std::string_view &value)
+    {
+        static_assert(isSorted(), "knownEntities must be sorted by name without duplicates");
+        static_assert(kEntities < 65536, "bucket offsets are 16-bit");
+        static constexpr Buckets buckets = buildBuckets();
+
+        unsigned char c = static_cast<unsigned char>(name[0]);
+        const KnownEntity *begin = knownEntities + buckets.first[c];
+        const KnownEntity *end = knownEntities + buckets.first[c + 1];
+        const KnownEntity *it = std::lower_bound(begin, end, name, [](const KnownEntity &entity, std::string_view key)
+                                                 { return entity.name.substr(1) < key; });
+        if (it == end || it->name.substr(1) != name)
+            return false;
+        value = it->value;
+        return true;
+    }
+
+    static size_t matchNumeric(std::string_view text, uint32_t &code)
+    {
+        size_t i = 1;
+        bool hex = i < text.size() && (text[i] == 'x' || text[i] == 'X');
+        if (hex)
+            ++i;
+        size_t digitsStart = i;
+        code = 0;
+        for (; i < text.size(); ++i)
+        {
+            char c = text[i];
+            uint32_t digit;
+            if (c >= '0' && c <= '9')
+                digit = static_cast<uint32_t>(c - '0');
+            else if (hex && ((c | 0x20) >= 'a' && (c | 0x20) <= 'f'))
+                digit = static_cast<uint32_t>((c | 0x20) - 'a' + 10);
+            else
+                break;
+            code = code > 0x10FFFF ? code : code * (hex ? 16 : 10) + digit;
+        }
+        if (i == digitsStart)
+            return 0;
+        if (i < text.size() && text[i] == ';')
+            ++i;
+
+        // Replacements of the HTML5 numeric character reference end state.
+        static const uint16_t windows1252[32] = {
+            0x20AC, 0x81, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021, 0x02C6, 0x2030, 0x0160, 0x2039, 0x0152, 0x8D, 0x017D, 0x8F,
+            0x90, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014, 0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0x9D, 0x017E, 0x0178};
+        if (code == 0 || code > 0x10FFFF || (code >= 0xD800 && code <= 0xDFFF))
+            code = 0xFFFD;
+        else if (code >= 0x80 && code <= 0x9F)
+            code = windows1252[code - 0x80];
+        return i;
+    }
+
+    static bool isAlnum(char c)
+    {
+        return (c >= '0' && c <= '9') || ((c | 0x20) >= 'a' && (c | 0x20) <= 'z');
+    }
+};
@@ -0,0 +1,208 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "GigaDom.hpp"
+#include "GigaSelector.hpp"
+#include "GigaTokenizer.hpp"
+
+enum class ExtractKind
+{
+    Text,      // text content of the matched element
+    Attribute, // value of ExtractField::attribute
+    Count,     // number of matches, as a decimal string
+    Exists     // "1" when anything matched, "0" otherwise
+};
+
+struct ExtractField
+{
+    std::string name;
+    std::string selector;
+    ExtractKind kind = ExtractKind::Text;
+    std::string attribute;
+    bool all = false; // every match instead of the first one
+    std::function<std::string(const std::string &)> transform;
+};
+
+// Declarative description of what to pull out of a page: field name ->
+// selector plus the rule applied to the matched elements.
+class ExtractionSpec
+{
+public:
+    ExtractionSpec &text(const std::string &name, const std::string &selector, bool all = false)
+    {
+        return add({name, selector, ExtractKind::Text, "", all, nullptr});
+    }
+
+    ExtractionSpec &attribute(const std::string &name, const std::string &selector, const std::string &attribute, bool all = false)
+    {
+        return add({name, selector, ExtractKind::Attribute, attribute, all, nullptr});
+    }
+
+    ExtractionSpec &count(const std::string &name, const std::string &selector)
+    {
+        return add({name, selector, ExtractKind::Count, "", false, nullptr});
+    }
+
+    ExtractionSpec &exists(const std::string &name, const std::string &selector)
+    {
+        return add({name, selector, ExtractKind::Exists, "", false, nullptr});
+    }
+
+    // Post-processing for the field added last (e.g. cleanTXT).
+    ExtractionSpec &transform(std::function<std::string(const std::string &)> fn)
+    {
+        if (!fields.empty())
+            fields.back().transform = std::move(fn);
+        return *this;
+    }
+
+    ExtractionSpec &add(ExtractField field)
+    {
+        fields.push_back(std::move(field));
+        return *this;
+    }
+
+    const std::vector<ExtractField> &getFields() const
+    {
+        return fields;
+    }
+
+private:
+    std::vector<ExtractField> fields;
+};
+
+struct ExtractedRecord
+{
+    std::vector<std::string> names;
+    std::vector<std::vector<std::string>> values;
+
+    // First value of the field, or "" when it has none.
+    std::string get(const std::string &name) const
+    {
+        for (size_t i = 0; i < names.size(); ++i)
+        {
+            if (names[i] == name)
+                return values[i].empty() ? "" : values[i].front();
+        }
+        return "";
+    }
+
+    const std::vector<std::string> &getAll(const std::string &name) const
+    {
+        static const std::vector<std::string> none;
+        for (size_t i = 0; i < names.size(); ++i)
+        {
+            if (names[i] == name)
+                return values[i];
+        }
+        return none;
+    }
+};
+
+// A spec compiled once: selectors are parsed and deduplicated into one
+// GigaSelectorSet, so each page costs a single walk over its DOM.
+class ExtractionPlan
+{
+public:
+    explicit ExtractionPlan(const ExtractionSpec &spec) : fields(spec.getFields())
+    {
+        std::vector<std::string> seen;
+        for (size_t i = 0; i < fields.size(); ++i)
+        {
+            size_t id = 0;
+            while (id < seen.size() && seen[id] != fields[i].selector)
+                ++id;
+            if (id == seen.size())
+            {
+                GigaSelector selector(fields[i].selector);
+                if (!selector.valid() && errorText.empty())
+                    errorText = fields[i].name + ": " + selector.error();
+                seen.push_back(fields[i].selector);
+                selectors.add(std::move(selector));
+                fieldsBySelector.emplace_back();
+            }
+            fieldsBySelector[id].push_back(i);
+        }
+    }
+
+    bool valid() const
+    {
+        return errorText.empty();
+    }
+
+    const std::string &error() const
+    {
+        return errorText;
+    }
+
+    ExtractedRecord apply(const FlatDom &dom) const
+    {
+        ExtractedRecord record;
+        record.values.resize(fields.size());
+        std::vector<size_t> matches(fields.size(), 0);
+        for (const ExtractField &field : fields)
+            record.names.push_back(field.name);
+
+        selectors.forEachMatch(dom, [&](size_t id, uint32_t node)
+                               {
+            for (size_t index : fieldsBySelector[id])
+            {
+                const ExtractField &field = fields[index];
+                ++matches[index];
+                if (field.kind == ExtractKind::Count || field.kind == ExtractKind::Exists)
+                    continue;
+                if (!field.all && !record.values[index].empty())
+                    continue;
+
+                if (field.kind == ExtractKind::Text)
+                {
+                    record.values[index].push_back(dom.textContent(node));
+                }
+                else
+                {
+                    std::string_view value;
+                    if (dom.attribute(node, field.attribute, value))
+                        record.values[index].emplace_back(value);
+                }
+            } });
+
+        for (size_t i = 0; i < fields.size(); ++i)
+        {
+            const ExtractField &field = fields[i];
+            if (field.kind == ExtractKind::Count)
+                record.values[i].push_back(std::to_string(matches[i]));
+            else if (field.kind == ExtractKind::Exists)
+                record.values[i].push_back(matches[i] ? "1" : "0");
+
+            if (field.transform)
+            {
+                for (std::string &value : record.values[i])
+                    value = field.transform(value);
+            }
+        }
+        return record;
+    }
+
+    // Tokenizes the page with GigaTokenizer; use apply(FlatDom) for a Gumbo DOM.
+    ExtractedRecord apply(std::string_view html) const
+    {
+        return apply(GigaTokenizer::toFlatDom(html));
+    }
+
+    std::vector<ExtractedRecord> applyAll(const std::vector<std::string> &pages) const
+    {
+        std::vector<ExtractedRecord> records;
+        records.reserve(pages.size());
+        for (const std::string &page : pages)
+            records.push_back(apply(std::string_view(page)));
+        return records;
+    }
+
+private:
+    std::vector<ExtractField> fields;
+    GigaSelectorSet selectors;
+    std::vector<std::vector<size_t>> fieldsBySelector;
+    std::string errorText;
+};
@@ -0,0 +1,782 @@
+#pragma once
+#include <algorithm>
+#include <cctype>
+#include <curl/curl.h>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <regex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "GigaCache.hpp"
+#include "GigaCurl.hpp"
+#include "GigaShare.hpp"
+
+enum class FetchRejection
+{
+    None,
+    Status,
+    ContentType,
+    ContentLength,
+    BodySize,
+    DecompressionRatio
+};
+
+// Phase durations in seconds, derived from libcurl's cumulative timers.
+// tls is 0 for plain HTTP and reused connections; ttfb is the wait between
+// sending the request and receiving the first response byte.
+struct FetchTimings
+{
+    double dns = 0.0;
+    double connect = 0.0;
+    double tls = 0.0;
+    double ttfb = 0.0;
+    double redirect = 0.0;
+    double total = 0.0;
+};
+
+struct FetchResult
+{
+    std::string url;
+    std::string effectiveUrl;
+    std::string content;
+    long httpCode = 0;
+    std::string contentType;
+    CURLcode curlCode = CURLE_OK;
+    FetchRejection rejection = FetchRejection::None;
+    std::string error;
+    FetchTimings timings;
+    long redirectCount = 0;
+    curl_off_t wireBytes = 0;
+    size_t decodedBytes = 0;
+    curl_off_t headerBytes = 0;
+    curl_off_t requestBytes = 0;
+    bool fromCache = false;
+    bool success = false;
+};
+
+// Checked as soon as the final response headers arrive; a transfer that fails
+// any rule is aborted before (or while) its body is downloaded.
+// A limit of 0 disables the corresponding size check. maxDecompressionRatio
+// bounds decoded/wire bytes of a compressed body once more than
+// decompressionRatioFloor bytes have been decoded.
+struct FetchFilter
+{
+    long statusCode = 200;
+    std::vector<std::string> contentTypes = {"text/html", "application/json"};
+    curl_off_t maxContentLength = 0;
+    size_t maxBodySize = 0;
+    double maxDecompressionRatio = 100.0;
+    size_t decompressionRatioFloor = 1024 * 1024;
+};
+
+struct FetcherStats
+{
+    size_t transfers = 0;
+    size_t handlesCreated = 0;
+    size_t handlesReused = 0;
+    size_t connectionsOpened = 0;
+    size_t connectionsReused = 0;
+    size_t rejectedStatus = 0;
+    size_t rejectedContentType = 0;
+    size_t rejectedContentLength = 0;
+    size_t rejectedBodySize = 0;
+    size_t rejectedDecompressionRatio = 0;
+    curl_off_t wireBytes = 0;
+    curl_off_t decodedBytes = 0;
+    size_t cacheHits = 0;
+    size_t cacheMisses = 0;
+    size_t cacheRevalidations = 0;
+    size_t cacheStores = 0;
+};
+
+// Batch fetch engine on top of the libcurl multi interface. URLs are queued with
+// submit() and run() drives up to maxInFlight transfers at once on the calling
+// thread, handing each FetchResult to the callback as soon as it completes.
+// Easy handles are reset and kept in a pool after every transfer so their
+// connection caches (and the multi handle's) keep connections to a host alive.
+class GigaFetcher
+{
+public:
+    using CompletionCallback = std::function<void(FetchResult &)>;
+    // Receives the decoded body chunk by chunk instead of FetchResult::content;
+    // returning false aborts the transfer. Such transfers bypass the cache.
+    using BodyCallback = std::function<bool(const char *data, size_t length)>;
+
+    explicit GigaFetcher(size_t maxInFlight = 64, size_t maxIdleHandles = 64)
+        : maxInFlight(maxInFlight ? maxInFlight : 1), maxIdleHandles(maxIdleHandles)
+    {
+        gigaCurlGlobalInit();
+        multi = curl_multi_init();
+        curl_multi_setopt(multi, CURLMOPT_MAXCONNECTS, static_cast<long>(this->maxInFlight * 2));
+        headers = curl_slist_append(headers, userAgentHeader);
+    }
+
+    ~GigaFetcher()
+    {
+        for (auto &entry : active)
+        {
+            curl_multi_remove_handle(multi, entry.first);
+            curl_easy_cleanup(entry.first);
+            curl_slist_free_all(entry.second.requestHeaders);
+        }
+        for (CURL *curl : idleHandles)
+            curl_easy_cleanup(curl);
+        curl_multi_cleanup(multi);
+        curl_slist_free_all(headers);
+    }
+
+    GigaFetcher(const GigaFetcher &) = delete;
+    GigaFetcher &operator=(const GigaFetcher &) = delete;
+
+    static bool isValidURL(const std::string &url)
+    {
+        static const std::regex urlPattern(R"(^(https?|ftp)://[^\s/$.?#].[^\s]*$)");
+        return std::regex_match(url, urlPattern);
+    }
+
+    static const char *rejectionName(FetchRejection rejection)
+    {
+        switch (rejection)
+        {
+        case FetchRejection::Status:
+            return "status code";
+        case FetchRejection::ContentType:
+            return "content type";
+        case FetchRejection::ContentLength:
+            return "content length";
+        case FetchRejection::BodySize:
+            return "body size";
+        case FetchRejection::DecompressionRatio:
+            return "decompression ratio";
+        case FetchRejection::None:
+            break;
+        }
+        return "none";
+    }
+
+    static bool isAcceptedContentType(const FetchFilter &filter, const char *contentType)
+    {
+        if (filter.contentTypes.empty())
+            return true;
+        if (!contentType)
+            return false;
+
+        std::string type(contentType);
+        std::transform(type.begin(), type.end(), type.begin(), [](unsigned char c)
+                       { return std::tolower(c); });
+        for (const auto &allowed : filter.contentTypes)
+        {
+            if (type.find(allowed) != std::string::npos)
+                return true;
+        }
+        return false;
+    }
+
+    static bool isAcceptedResponse(const FetchFilter &filter, long httpCode, const char *contentType)
+    {
+        return (filter.statusCode == 0 || httpCode == filter.statusCode) && isAcceptedContentType(filter, contentType);
+    }
+
+    void setFilter(const FetchFilter &newFilter)
+    {
+        filter = newFilter;
+    }
+
+    const FetchFilter &getFilter() const
+    {
+        return filter;
+    }
+
+    // Value of the Accept-Encoding header; an empty string offers every encoding
+    // this libcurl build can decode (gzip, deflate and, when available, br and zstd).
+    void setAcceptEncoding(const std::string &encodings)
+    {
+        acceptEncoding = encodings;
+        compression = true;
+    }
+
+    void disableCompression()
+    {
+        compression = false;
+    }
+
+    // Keeps accepted responses that carry an ETag or Last-Modified in directory and
+    // revalidates them with conditional requests; a 304 is answered from disk.
+    void enableCache(const std::string &directory)
+    {
+        cache = std::make_unique<GigaCache>(directory);
+    }
+
+    void disableCache()
+    {
+        cache.reset();
+    }
+
+    // A GigaFetcher is used by one thread at a time; fetchers on different
+    // threads can pass the same GigaShare to pool DNS results and TLS sessions.
+    void setShare(std::shared_ptr<GigaShare> newShare)
+    {
+        share = std::move(newShare);
+    }
+
+    void setMaxInFlight(size_t count)
+    {
+        maxInFlight = count ? count : 1;
+        curl_multi_setopt(multi, CURLMOPT_MAXCONNECTS, static_cast<long>(maxInFlight * 2));
+    }
+
+    // 0 means no per-host limit; transfers above the limit wait for a free connection.
+    void setMaxConnectionsPerHost(long count)
+    {
+        curl_multi_setopt(multi, CURLMOPT_MAX_HOST_CONNECTIONS, count);
+    }
+
+    const FetcherStats &getStats() const
+    {
+        return stats;
+    }
+
+    void resetStats()
+    {
+        stats = FetcherStats();
+    }
+
+    // Blocking single fetch on a pooled handle.
+    FetchResult fetch(const std::string &url, BodyCallback onBody = nullptr)
+    {
+        FetchResult result;
+        result.url = url;
+        if (!isValidURL(url))
+        {
+            result.curlCode = CURLE_URL_MALFORMAT;
+            result.error = "Bad URL";
+            return result;
+        }
+
+        CURL *curl = acquireHandle();
+        if (!curl)
+        {
+            result.curlCode = CURLE_FAILED_INIT;
+            result.error = curl_easy_strerror(result.curlCode);
+            return result;
+        }
+
+        Transfer transfer{this, curl, std::move(result)};
+        transfer.onBody = std::move(onBody);
+        configureHandle(transfer);
+        finishTransfer(transfer, curl_easy_perform(curl));
+        releaseHandle(curl);
+        return std::move(transfer.result);
+    }
+
+    size_t getMaxInFlight() const
+    {
+        return maxInFlight;
+    }
+
+    void submit(const std::string &url)
+    {
+        queued.push_back({url, nullptr, nullptr});
+    }
+
+    void submit(const std::vector<std::string> &urls)
+    {
+        for (const auto &url : urls)
+            queued.push_back({url, nullptr, nullptr});
+    }
+
+    // onDone receives this URL's result instead of the run() callback.
+    void submit(const std::string &url, CompletionCallback onDone, BodyCallback onBody = nullptr)
+    {
+        queued.push_back({url, std::move(onDone), std::move(onBody)});
+    }
+
+    size_t pending() const
+    {
+        return queued.size() + active.size();
+    }
+
+    // Runs until every submitted URL (including ones submitted from inside the
+    // callback) has completed.
+    void run(const CompletionCallback &onComplete)
+    {
+        while (pending())
+            runOnce(onComplete);
+    }
+
+    // Starts queued transfers, waits up to timeoutMs for socket activity and
+    // reports the transfers that finished. Waits the full timeout when idle.
+    void runOnce(const CompletionCallback &onComplete, int timeoutMs = 1000)
+    {
+        startQueued(onComplete);
+
+        int running = 0;
+        CURLMcode mc = curl_multi_perform(multi, &running);
+        if (mc == CURLM_OK)
+            mc = curl_multi_poll(multi, nullptr, 0, timeoutMs, nullptr);
+        if (mc != CURLM_OK)
+        {
+            std::cerr << "curl_multi failed: " << curl_multi_strerror(mc) << std::endl;
+            abortActive(onComplete, CURLE_FAILED_INIT);
+            return;
+        }
+
+        collectFinished(onComplete);
+    }
+
+    // Event-driven mode: the caller watches sockets itself (e.g. with epoll) and
+    // reports activity through socketAction() instead of calling runOnce().
+    void setSocketCallbacks(curl_socket_callback socketFunction, curl_multi_timer_callback timerFunction, void *userp)
+    {
+        curl_multi_setopt(multi, CURLMOPT_SOCKETFUNCTION, socketFunction);
+        curl_multi_setopt(multi, CURLMOPT_SOCKETDATA, userp);
+        curl_multi_setopt(multi, CURLMOPT_TIMERFUNCTION, timerFunction);
+        curl_multi_setopt(multi, CURLMOPT_TIMERDATA, userp);
+    }
+
+    void socketAction(curl_socket_t socket, int events, const CompletionCallback &onComplete = nullptr)
+    {
+        startQueued(onComplete);
+
+        int running = 0;
+        CURLMcode mc = curl_multi_socket_action(multi, socket, events, &running);
+        if (mc != CURLM_OK)
+        {
+            std::cerr << "curl_multi failed: " << curl_multi_strerror(mc) << std::endl;
+            abortActive(onComplete, CURLE_FAILED_INIT);
+            return;
+        }
+
+        collectFinished(onComplete);
+        startQueued(onComplete);
+    }
+
+    std::vector<FetchResult> fetchAll(const std::vector<std::string> &urls)
+    {
+        std::vector<FetchResult> results;
+        results.reserve(urls.size());
+        submit(urls);
+        run([&results](FetchResult &result)
+            { results.push_back(std::move(result)); });
+        return results;
+    }
+
+private:
+    static constexpr const char *userAgentHeader = "User-Agent: Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/58.0.3029.110 Safari/537";
+
+    struct QueuedFetch
+    {
+        std::string url;
+        CompletionCallback onDone;
+        BodyCallback onBody;
+    };
+
+    struct Transfer
+    {
+        Transfer(GigaFetcher *owner, CURL *curl, FetchResult result) : owner(owner), curl(curl), result(std::move(result)) {}
+
+        GigaFetcher *owner;
+        CURL *curl;
+        FetchResult result;
+        CompletionCallback onDone;
+        BodyCallback onBody;
+        CacheEntry cached;
+        bool hasCached = false;
+        struct curl_slist *requestHeaders = nullptr;
+    };
+
+    CURLM *multi = nullptr;
+    struct curl_slist *headers = nullptr;
+    size_t maxInFlight;
+    size_t maxIdleHandles;
+    std::deque<QueuedFetch> queued;
+    std::unordered_map<CURL *, Transfer> active;
+    std::vector<CURL *> idleHandles;
+    FetchFilter filter;
+    std::string acceptEncoding;
+    bool compression = true;
+    std::unique_ptr<GigaCache> cache;
+    std::shared_ptr<GigaShare> share;
+    FetcherStats stats;
+
+    CURL *acquireHandle()
+    {
+        if (!idleHandles.empty())
+        {
+            CURL *curl = idleHandles.back();
+            idleHandles.pop_back();
+            ++stats.handlesReused;
+            return curl;
+        }
+
+        CURL *curl = curl_easy_init();
+        if (curl)
+            ++stats.handlesCreated;
+        return curl;
+    }
+
+    void releaseHandle(CURL *curl)
+    {
+        if (idleHandles.size() >= maxIdleHandles)
+        {
+            curl_easy_cleanup(curl);
+            return;
+        }
+        curl_easy_reset(curl);
+        idleHandles.push_back(curl);
+    }
+
+    void configureHandle(Transfer &transfer)
+    {
+        CURL *curl = transfer.curl;
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+        if (cache && !transfer.onBody)
+            addValidators(transfer);
+        curl_easy_setopt(curl, CURLOPT_URL, transfer.result.url.c_str());
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &transfer);
+        curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, HeaderCallback);
+        curl_easy_setopt(curl, CURLOPT_HEADERDATA, &transfer);
+        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+        curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+        if (filter.maxContentLength > 0)
+            curl_easy_setopt(curl, CURLOPT_MAXFILESIZE_LARGE, filter.maxContentLength);
+        if (compression)
+            curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, acceptEncoding.c_str());
+        if (share)
+            curl_easy_setopt(curl, CURLOPT_SHARE, share->handle());
+    }
+
+    void addValidators(Transfer &transfer)
+    {
+        transfer.hasCached = cache->load(transfer.result.url, transfer.cached) &&
+                             (!transfer.cached.etag.empty() || !transfer.cached.lastModified.empty());
+        if (!transfer.hasCached)
+        {
+            ++stats.cacheMisses;
+            return;
+        }
+
+        ++stats.cacheRevalidations;
+        if (!transfer.cached.etag.empty())
+        {
+            for (struct curl_slist *header = headers; header; header = header->next)
+                transfer.requestHeaders = curl_slist_append(transfer.requestHeaders, header->data);
+            transfer.requestHeaders = curl_slist_append(transfer.requestHeaders, ("If-None-Match: " + transfer.cached.etag).c_str());
+            curl_easy_setopt(transfer.curl, CURLOPT_HTTPHEADER, transfer.requestHeaders);
+        }
+        if (!transfer.cached.lastModified.empty())
+        {
+            time_t modified = curl_getdate(transfer.cached.lastModified.c_str(), nullptr);
+            if (modified != -1)
+            {
+                curl_easy_setopt(transfer.curl, CURLOPT_TIMECONDITION, static_cast<long>(CURL_TIMECOND_IFMODSINCE));
+                curl_easy_setopt(transfer.curl, CURLOPT_TIMEVALUE_LARGE, static_cast<curl_off_t>(modified));
+            }
+        }
+    }
+
+    static std::string responseHeader(CURL *curl, const char *name)
+    {
+        struct curl_header *header = nullptr;
+        if (curl_easy_header(curl, name, 0, CURLH_HEADER, -1, &header) != CURLHE_OK)
+            return "";
+        return header->value;
+    }
+
+    // Serves a 304 from the cached entry, or stores a fresh response that has validators.
+    void updateCache(Transfer &transfer)
+    {
+        FetchResult &result = transfer.result;
+        if (transfer.hasCached && result.httpCode == 304)
+        {
+            ++stats.cacheHits;
+            result.content = std::move(transfer.cached.body);
+            result.contentType = transfer.cached.contentType;
+            result.httpCode = transfer.cached.httpCode;
+            result.fromCache = true;
+            return;
+        }
+
+        if (result.curlCode != CURLE_OK || result.rejection != FetchRejection::None ||
+            !isAcceptedResponse(filter, result.httpCode, result.contentType.c_str()))
+            return;
+
+        CacheEntry entry;
+        entry.etag = responseHeader(transfer.curl, "ETag");
+        entry.lastModified = responseHeader(transfer.curl, "Last-Modified");
+        if (entry.etag.empty() && entry.lastModified.empty())
+        {
+            if (transfer.hasCached)
+                cache->erase(result.url);
+            return;
+        }
+
+        entry.url = result.url;
+        entry.contentType = result.contentType;
+        entry.httpCode = result.httpCode;
+        entry.body = result.content;
+        if (cache->store(entry))
+            ++stats.cacheStores;
+    }
+
+    void countRejection(FetchRejection rejection)
+    {
+        switch (rejection)
+        {
+        case FetchRejection::Status:
+            ++stats.rejectedStatus;
+            break;
+        case FetchRejection::ContentType:
+            ++stats.rejectedContentType;
+            break;
+        case FetchRejection::ContentLength:
+            ++stats.rejectedContentLength;
+            break;
+        case FetchRejection::BodySize:
+            ++stats.rejectedBodySize;
+            break;
+        case FetchRejection::DecompressionRatio:
+            ++stats.rejectedDecompressionRatio;
+            break;
+        case FetchRejection::None:
+            break;
+        }
+    }
+
+    void finishTransfer(Transfer &transfer, CURLcode code)
+    {
+        CURL *curl = transfer.curl;
+        FetchResult &result = transfer.result;
+        ++stats.transfers;
+        result.curlCode = code;
+
+        if (code == CURLE_FILESIZE_EXCEEDED)
+            result.rejection = FetchRejection::ContentLength;
+        countRejection(result.rejection);
+
+        readMetrics(curl, result);
+        stats.wireBytes += result.wireBytes;
+        stats.decodedBytes += result.decodedBytes;
+
+        long connects = 0;
+        curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &connects);
+        stats.connectionsOpened += connects;
+        if (code == CURLE_OK && connects == 0)
+            ++stats.connectionsReused;
+
+        char *contentType = nullptr;
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &result.httpCode);
+        curl_easy_getinfo(curl, CURLINFO_CONTENT_TYPE, &contentType);
+        if (contentType)
+            result.contentType = contentType;
+
+        curl_slist_free_all(transfer.requestHeaders);
+        transfer.requestHeaders = nullptr;
+        if (cache && code == CURLE_OK && !transfer.onBody)
+            updateCache(transfer);
+
+        if (code != CURLE_OK)
+        {
+            result.error = curl_easy_strerror(code);
+            if (result.rejection != FetchRejection::None)
+                result.error = std::string("rejected by ") + rejectionName(result.rejection) + " filter";
+            return;
+        }
+
+        result.success = result.rejection == FetchRejection::None &&
+                         isAcceptedResponse(filter, result.httpCode, result.contentType.c_str());
+        if (!result.success)
+            result.error = "unexpected status " + std::to_string(result.httpCode) + " or content type '" + result.contentType + "'";
+    }
+
+    static void readMetrics(CURL *curl, FetchResult &result)
+    {
+        curl_off_t nameLookup = 0, connect = 0, appConnect = 0, preTransfer = 0, startTransfer = 0, total = 0, redirect = 0;
+        curl_easy_getinfo(curl, CURLINFO_NAMELOOKUP_TIME_T, &nameLookup);
+        curl_easy_getinfo(curl, CURLINFO_CONNECT_TIME_T, &connect);
+        curl_easy_getinfo(curl, CURLINFO_APPCONNECT_TIME_T, &appConnect);
+        curl_easy_getinfo(curl, CURLINFO_PRETRANSFER_TIME_T, &preTransfer);
+        curl_easy_getinfo(curl, CURLINFO_STARTTRANSFER_TIME_T, &startTransfer);
+        curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME_T, &total);
+        curl_easy_getinfo(curl, CURLINFO_REDIRECT_TIME_T, &redirect);
+
+        auto seconds = [](curl_off_t micros)
+        { return micros > 0 ? static_cast<double>(micros) / 1e6 : 0.0; };
+        result.timings.dns = seconds(nameLookup);
+        result.timings.connect = seconds(connect - nameLookup);
+        result.timings.tls = appConnect > 0 ? seconds(appConnect - connect) : 0.0;
+        result.timings.ttfb = seconds(startTransfer - preTransfer);
+        result.timings.redirect = seconds(redirect);
+        result.timings.total = seconds(total);
+
+        char *effectiveUrl = nullptr;
+        curl_easy_getinfo(curl, CURLINFO_EFFECTIVE_URL, &effectiveUrl);
+        if (effectiveUrl)
+            result.effectiveUrl = effectiveUrl;
+
+        long headerBytes = 0, requestBytes = 0;
+        curl_easy_getinfo(curl, CURLINFO_REDIRECT_COUNT, &result.redirectCount);
+        curl_easy_getinfo(curl, CURLINFO_HEADER_SIZE, &headerBytes);
+        curl_easy_getinfo(curl, CURLINFO_REQUEST_SIZE, &requestBytes);
+        curl_easy_getinfo(curl, CURLINFO_SIZE_DOWNLOAD_T, &result.wireBytes);
+        result.headerBytes = headerBytes;
+        result.requestBytes = requestBytes;
+    }
+
+    // Runs once the header block of the final (non-redirect) response is complete.
+    FetchRejection checkHeaders(CURL *curl) const
+    {
+        long httpCode = 0;
+        char *contentType = nullptr;
+        curl_off_t contentLength = -1;
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &httpCode);
+        curl_easy_getinfo(curl, CURLINFO_CONTENT_TYPE, &contentType);
+        curl_easy_getinfo(curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &contentLength);
+
+        if (filter.statusCode != 0 && httpCode != filter.statusCode)
+            return FetchRejection::Status;
+        if (!isAcceptedContentType(filter, contentType))
+            return FetchRejection::ContentType;
+        if (filter.maxContentLength > 0 && contentLength > filter.maxContentLength)
+            return FetchRejection::ContentLength;
+        if (filter.maxBodySize > 0 && contentLength > static_cast<curl_off_t>(filter.maxBodySize))
+            return FetchRejection::BodySize;
+        return FetchRejection::None;
+    }
+
+    static size_t HeaderCallback(char *buffer, size_t size, size_t nitems, void *userp)
+    {
+        Transfer *transfer = static_cast<Transfer *>(userp);
+        size_t length = size * nitems;
+        if (length > 2 || (length == 2 && buffer[0] != '\r') || (length == 1 && buffer[0] != '\n'))
+            return length;
+
+        long httpCode = 0;
+        curl_easy_getinfo(transfer->curl, CURLINFO_RESPONSE_CODE, &httpCode);
+        if (httpCode < 200 || (httpCode >= 300 && httpCode < 400))
+            return length;
+
+        transfer->result.rejection = transfer->owner->checkHeaders(transfer->curl);
+        return transfer->result.rejection == FetchRejection::None ? length : 0;
+    }
+
+    static size_t WriteCallback(void *contents, size_t size, size_t nmemb, void *userp)
+    {
+        Transfer *transfer = static_cast<Transfer *>(userp);
+        const FetchFilter &filter = transfer->owner->filter;
+        FetchResult &result = transfer->result;
+        size_t length = size * nmemb;
+        if (filter.maxBodySize > 0 && result.decodedBytes + length > filter.maxBodySize)
+        {
+            result.rejection = FetchRejection::BodySize;
+            return 0;
+        }
+
+        result.decodedBytes += length;
+        if (filter.maxDecompressionRatio > 0 && result.decodedBytes > filter.decompressionRatioFloor)
+        {
+            curl_off_t wireBytes = 0;
+            curl_easy_getinfo(transfer->curl, CURLINFO_SIZE_DOWNLOAD_T, &wireBytes);
+            if (static_cast<double>(result.decodedBytes) > filter.maxDecompressionRatio * static_cast<double>(std::max<curl_off_t>(wireBytes, 1)))
+            {
+                result.rejection = FetchRejection::DecompressionRatio;
+                return 0;
+            }
+        }
+
+        if (transfer->onBody)
+            return transfer->onBody(static_cast<const char *>(contents), length) ? length : 0;
+
+        result.content.append((char *)contents, length);
+        return length;
+    }
+
+    void startQueued(const CompletionCallback &onComplete)
+    {
+        while (!queued.empty() && active.size() < maxInFlight)
+        {
+            QueuedFetch next = std::move(queued.front());
+            queued.pop_front();
+
+            FetchResult result;
+            result.url = std::move(next.url);
+
+            if (!isValidURL(result.url))
+            {
+                result.curlCode = CURLE_URL_MALFORMAT;
+                result.error = "Bad URL";
+                deliver(result, next.onDone, onComplete);
+                continue;
+            }
+
+            CURL *curl = acquireHandle();
+            if (!curl)
+            {
+                result.curlCode = CURLE_FAILED_INIT;
+                result.error = curl_easy_strerror(result.curlCode);
+                deliver(result, next.onDone, onComplete);
+                continue;
+            }
+
+            Transfer &transfer = active.emplace(curl, Transfer{this, curl, std::move(result)}).first->second;
+            transfer.onDone = std::move(next.onDone);
+            transfer.onBody = std::move(next.onBody);
+            configureHandle(transfer);
+            curl_multi_add_handle(multi, curl);
+        }
+    }
+
+    static void deliver(FetchResult &result, const CompletionCallback &onDone, const CompletionCallback &onComplete)
+    {
+        if (onDone)
+            onDone(result);
+        else if (onComplete)
+            onComplete(result);
+    }
+
+    void collectFinished(const CompletionCallback &onComplete)
+    {
+        int remaining = 0;
+        while (CURLMsg *msg = curl_multi_info_read(multi, &remaining))
+        {
+            if (msg->msg != CURLMSG_DONE)
+                continue;
+
+            CURL *curl = msg->easy_handle;
+            auto it = active.find(curl);
+            if (it == active.end())
+                continue;
+
+            finishTransfer(it->second, msg->data.result);
+            FetchResult result = std::move(it->second.result);
+            CompletionCallback onDone = std::move(it->second.onDone);
+            active.erase(it);
+
+            curl_multi_remove_handle(multi, curl);
+            releaseHandle(curl);
+
+            deliver(result, onDone, onComplete);
+        }
+    }
+
+    void abortActive(const CompletionCallback &onComplete, CURLcode code)
+    {
+        std::vector<std::pair<FetchResult, CompletionCallback>> aborted;
+        for (auto &entry : active)
+        {
+            curl_multi_remove_handle(multi, entry.first);
+            releaseHandle(entry.first);
+            curl_slist_free_all(entry.second.requestHeaders);
+            entry.second.result.curlCode = code;
+            entry.second.result.error = curl_easy_strerror(code);
+            aborted.emplace_back(std::move(entry.second.result), std::move(entry.second.onDone));
+        }
+        active.clear();
+        for (auto &entry : aborted)
+            deliver(entry.first, entry.second, onComplete);
+    }
+};
@@ -0,0 +1,196 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "GigaScan.hpp"
+
+// Structural index of an HTML buffer, built in one vectorized pass: the
+// positions of every '<', '>' and quote. Tag openers are bucketed by the byte
+// after "<" (or after "</"), so finding "<tag" or "</tag" only visits tags
+// starting with the same letter. find() returns exactly what
+// std::string::find would. The buffer must outlive the index.
+class HtmlIndex
+{
+public:
+    // Positions are stored in 32 bits; larger buffers are not indexed and
+    // every query falls back to a plain scan.
+    static constexpr size_t kMaxSource = UINT32_MAX;
+
+    explicit HtmlIndex(std::string_view html) : html(html)
+    {
+        std::fill(bucketStart.begin(), bucketStart.end(), 0);
+        if (!indexed())
+            return;
+
+        const char *begin = html.data();
+        const char *end = begin + html.size();
+        std::vector<uint32_t> opens;
+        for (size_t offset = 0; offset < html.size(); offset += 64)
+        {
+            uint64_t mask = GigaScan::matchMask64(begin + offset, end, '<', '>', '"', '\'');
+            while (mask)
+            {
+                uint32_t pos = static_cast<uint32_t>(offset + GigaScan::firstBit(mask));
+                mask &= mask - 1;
+                switch (html[pos])
+                {
+                case '<':
+                    opens.push_back(pos);
+                    break;
+                case '>':
+                    closers.push_back(pos);
+                    break;
+                default:
+                    quotes.push_back(pos);
+                    break;
+                }
+            }
+        }
+
+        // Counting sort of the '<' positions by key; stable, so each bucket
+        // stays in document order.
+        for (uint32_t pos : opens)
+            ++bucketStart[keyAt(pos) + 1];
+        for (size_t i = 1; i < bucketStart.size(); ++i)
+            bucketStart[i] += bucketStart[i - 1];
+        tags.resize(opens.size());
+        std::array<uint32_t, kKeys> fill;
+        std::copy(bucketStart.begin(), bucketStart.end() - 1, fill.begin());
+        for (uint32_t pos : opens)
+            tags[fill[keyAt(pos)]++] = pos;
+        lessThan = std::move(opens);
+    }
+
+    std::string_view source() const
+    {
+        return html;
+    }
+
+    // False when the buffer is larger than kMaxSource.
+    bool indexed() const
+    {
+        return html.size() <= kMaxSource;
+    }
+
+    // Same result as std::string::find(pattern, from).
+    size_t find(std::string_view pattern, size_t from = 0) const
+    {
+        if (!indexed() || pattern.empty() || from >= html.size())
+            return html.find(pattern, from);
+
+        const std::vector<uint32_t> *candidates = nullptr;
+        const uint32_t *first = nullptr;
+        const uint32_t *last = nullptr;
+        switch (pattern[0])
+        {
+        case '<':
+            if (pattern.size() >= 3 && pattern[1] == '/')
+            {
+                bucket(256 + static_cast<unsigned char>(pattern[2]), first, last);
+            }
+            else if (pattern.size() >= 2 && pattern[1] != '/')
+            {
+                bucket(static_cast<unsigned char>(pattern[1]), first, last);
+            }
+            else
+            {
+                candidates = &lessThan;
+            }
+            break;
+        case '>':
+            candidates = &closers;
+            break;
+        case '"':
+        case '\'':
+            return scan(quotes, pattern, from);
+        default:
+            return html.find(pattern, from);
+        }
+
+        if (candidates)
+            return scan(*candidates, pattern, from);
+
+        for (const uint32_t *it = std::lower_bound(first, last, static_cast<uint32_t>(from)); it != last; ++it)
+        {
+            if (html.compare(*it, pattern.size(), pattern) == 0)
+                return *it;
+        }
+        return std::string_view::npos;
+    }
+
+    // Same result as std::string::find_first_of("\"'", from).
+    size_t findQuote(size_t from) const
+    {
+        if (!indexed())
+            return html.find_first_of("\"'", from);
+        auto it = std::lower_bound(quotes.begin(), quotes.end(), static_cast<uint32_t>(std::min<size_t>(from, UINT32_MAX)));
+        return it == quotes.end() ? std::string_view::npos : *it;
+    }
+
+    // Number of non-overlapping matches, as a find() loop stepping by the
+    // pattern length would count them.
+    size_t count(std::string_view pattern) const
+    {
+        size_t matches = 0;
+        if (pattern.empty())
+            return 0;
+        for (size_t pos = find(pattern); pos != std::string_view::npos; pos = find(pattern, pos + pattern.size()))
+            ++matches;
+        return matches;
+    }
+
+    // The positions below are empty when the buffer is not indexed.
+    const std::vector<uint32_t> &getTagOpeners() const
+    {
+        return lessThan;
+    }
+
+    const std::vector<uint32_t> &getTagClosers() const
+    {
+        return closers;
+    }
+
+    const std::vector<uint32_t> &getQuotes() const
+    {
+        return quotes;
+    }
+
+private:
+    // 0..255: byte after '<'; 256..511: byte after "</".
+    static constexpr size_t kKeys = 512;
+
+    std::string_view html;
+    std::vector<uint32_t> lessThan;
+    std::vector<uint32_t> closers;
+    std::vector<uint32_t> quotes;
+    std::vector<uint32_t> tags;
+    std::array<uint32_t, kKeys + 1> bucketStart;
+
+    size_t keyAt(size_t pos) const
+    {
+        unsigned char next = pos + 1 < html.size() ? static_cast<unsigned char>(html[pos + 1]) : 0;
+        if (next != '/')
+            return next;
+        return 256 + (pos + 2 < html.size() ? static_cast<unsigned char>(html[pos + 2]) : 0);
+    }
+
+    void bucket(size_t key, const uint32_t *&first, const uint32_t *&last) const
+    {
+        first = tags.data() + bucketStart[key];
+        last = tags.data() + bucketStart[key + 1];
+    }
+
+    size_t scan(const std::vector<uint32_t> &positions, std::string_view pattern, size_t from) const
+    {
+        for (auto it = std::lower_bound(positions.begin(), positions.end(), static_cast<uint32_t>(from)); it != positions.end(); ++it)
+        {
+            if (html.compare(*it, pattern.size(), pattern) == 0)
+                return *it;
+        }
+        return std::string_view::npos;
+    }
+};
@@ -0,0 +1,147 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+#include "GigaFetcher.hpp"
+
+struct LatencyPercentiles
+{
+    double p50 = 0.0;
+    double p90 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+};
+
+struct HostMetrics
+{
+    size_t requests = 0;
+    size_t failures = 0;
+    curl_off_t wireBytes = 0;
+    curl_off_t decodedBytes = 0;
+    LatencyPercentiles dns;
+    LatencyPercentiles connect;
+    LatencyPercentiles tls;
+    LatencyPercentiles ttfb;
+    LatencyPercentiles total;
+};
+
+// Collects FetchResult timings per host. Each host keeps at most
+// samplesPerHost samples (reservoir sampling), so memory stays bounded on
+// long crawls while percentiles remain representative.
+class GigaMetrics
+{
+public:
+    using HostKey = std::function<std::string(const std::string &)>;
+
+    explicit GigaMetrics(HostKey hostKey, size_t samplesPerHost = 4096)
+        : hostKey(std::move(hostKey)), samplesPerHost(samplesPerHost ? samplesPerHost : 1)
+    {
+    }
+
+    void record(const FetchResult &result)
+    {
+        HostSamples &host = hosts[hostKey(result.url)];
+        ++host.requests;
+        if (!result.success)
+            ++host.failures;
+        host.wireBytes += result.wireBytes;
+        host.decodedBytes += static_cast<curl_off_t>(result.decodedBytes);
+
+        if (result.curlCode != CURLE_OK && result.timings.total == 0.0)
+            return;
+
+        size_t slot = host.timings.size();
+        if (slot >= samplesPerHost)
+        {
+            slot = static_cast<size_t>(nextRandom() % host.requests);
+            if (slot >= samplesPerHost)
+                return;
+            host.timings[slot] = result.timings;
+        }
+        else
+        {
+            host.timings.push_back(result.timings);
+        }
+    }
+
+    std::vector<std::string> getHosts() const
+    {
+        std::vector<std::string> names;
+        names.reserve(hosts.size());
+        for (const auto &entry : hosts)
+            names.push_back(entry.first);
+        return names;
+    }
+
+    HostMetrics summary(const std::string &host) const
+    {
+        HostMetrics metrics;
+        auto it = hosts.find(host);
+        if (it == hosts.end())
+            return metrics;
+
+        const HostSamples &samples = it->second;
+        metrics.requests = samples.requests;
+        metrics.failures = samples.failures;
+        metrics.wireBytes = samples.wireBytes;
+        metrics.decodedBytes = samples.decodedBytes;
+        metrics.dns = percentiles(samples.timings, &FetchTimings::dns);
+        metrics.connect = percentiles(samples.timings, &FetchTimings::connect);
+        metrics.tls = percentiles(samples.timings, &FetchTimings::tls);
+        metrics.ttfb = percentiles(samples.timings, &FetchTimings::ttfb);
+        metrics.total = percentiles(samples.timings, &FetchTimings::total);
+        return metrics;
+    }
+
+    void clear()
+    {
+        hosts.clear();
+    }
+
+private:
+    struct HostSamples
+    {
+        size_t requests = 0;
+        size_t failures = 0;
+        curl_off_t wireBytes = 0;
+        curl_off_t decodedBytes = 0;
+        std::vector<FetchTimings> timings;
+    };
+
+    HostKey hostKey;
+    size_t samplesPerHost;
+    std::map<std::string, HostSamples> hosts;
+    uint64_t randomState = 0x9E3779B97F4A7C15ULL;
+
+    uint64_t nextRandom()
+    {
+        randomState ^= randomState << 13;
+        randomState ^= randomState >> 7;
+        randomState ^= randomState << 17;
+        return randomState;
+    }
+
+    static LatencyPercentiles percentiles(const std::vector<FetchTimings> &timings, double FetchTimings::*field)
+    {
+        LatencyPercentiles result;
+        if (timings.empty())
+            return result;
+
+        std::vector<double> values;
+        values.reserve(timings.size());
+        for (const auto &timing : timings)
+            values.push_back(timing.*field);
+        std::sort(values.begin(), values.end());
+
+        auto at = [&values](double fraction)
+        { return values[static_cast<size_t>(fraction * static_cast<double>(values.size() - 1) + 0.5)]; };
+        result.p50 = at(0.50);
+        result.p90 = at(0.90);
+        result.p99 = at(0.99);
+        result.max = values.back();
+        return result;
+    }
+};
@@ -0,0 +1,111 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <gumbo.h>
+
+// Set of GumboTag values packed into bits, usable in constant expressions.
+// GUMBO_TAG_UNKNOWN is never a member: flat DOM nodes that are not elements
+// carry that tag, so contains(node.tag) alone tells whether to skip a node.
+class TagSet
+{
+public:
+    constexpr TagSet() = default;
+
+    constexpr TagSet(std::initializer_list<GumboTag> tags)
+    {
+        for (GumboTag tag : tags)
+            set(tag, true);
+    }
+
+    constexpr bool contains(uint16_t tag) const
+    {
+        return (words[tag >> 6 & (kWords - 1)] >> (tag & 63)) & 1;
+    }
+
+    constexpr TagSet with(GumboTag tag) const
+    {
+        TagSet copy = *this;
+        copy.set(tag, true);
+        return copy;
+    }
+
+    constexpr TagSet without(GumboTag tag) const
+    {
+        TagSet copy = *this;
+        copy.set(tag, false);
+        return copy;
+    }
+
+private:
+    // A power of two, so contains() can mask instead of bounds checking.
+    static constexpr size_t kWords = GUMBO_TAG_LAST <= 128 ? 2 : GUMBO_TAG_LAST <= 256 ? 4 : 8;
+    static_assert(GUMBO_TAG_LAST <= 512, "TagSet is too small for GumboTag");
+
+    uint64_t words[kWords] = {};
+
+    constexpr void set(GumboTag tag, bool member)
+    {
+        if (tag >= GUMBO_TAG_UNKNOWN)
+            return;
+        uint64_t bit = uint64_t(1) << (tag & 63);
+        if (member)
+            words[tag >> 6] |= bit;
+        else
+            words[tag >> 6] &= ~bit;
+    }
+};
+
+// What the content extractors keep. Subtrees rooted at a tag in skipTags are
+// jumped over; a text node is kept when it has at least minWords words
+// (counted as spaces + 1) and its length is within [minLength, maxLength],
+// maxLength 0 meaning unlimited. dedup drops texts already returned.
+struct ExtractionPolicy
+{
+    TagSet skipTags;
+    size_t minWords = 0;
+    size_t minLength = 0;
+    size_t maxLength = 0;
+    bool dedup = true;
+
+    constexpr bool accepts(size_t words, size_t length) const
+    {
+        return words >= minWords && length >= minLength && (maxLength == 0 || length <= maxLength);
+    }
+
+    // getMainContent's fallback: everything but scripts, styles and templates.
+    static constexpr ExtractionPolicy mainContent()
+    {
+        return {{GUMBO_TAG_SCRIPT, GUMBO_TAG_STYLE, GUMBO_TAG_TEMPLATE}, 0, 0, 0, false};
+    }
+
+    // getMultipleContents: texts of more than 20 words outside page chrome.
+    static constexpr ExtractionPolicy multipleContents()
+    {
+        return {{GUMBO_TAG_SCRIPT, GUMBO_TAG_STYLE, GUMBO_TAG_TEMPLATE,
+                 GUMBO_TAG_HEADER, GUMBO_TAG_FOOTER, GUMBO_TAG_NAV, GUMBO_TAG_ASIDE},
+                21,
+                0,
+                0,
+                true};
+    }
+
+    // multipleContents() that also drops forms, menus and embedded content,
+    // for crawls that only want prose.
+    static constexpr ExtractionPolicy articleText()
+    {
+        return {{GUMBO_TAG_SCRIPT, GUMBO_TAG_STYLE, GUMBO_TAG_TEMPLATE, GUMBO_TAG_NOSCRIPT,
+                 GUMBO_TAG_HEADER, GUMBO_TAG_FOOTER, GUMBO_TAG_NAV, GUMBO_TAG_ASIDE,
+                 GUMBO_TAG_FORM, GUMBO_TAG_MENU, GUMBO_TAG_IFRAME, GUMBO_TAG_SVG, GUMBO_TAG_MATH},
+                21,
+                0,
+                0,
+                true};
+    }
+
+    // Every text node, in document order, duplicates included.
+    static constexpr ExtractionPolicy allText()
+    {
+        return {{GUMBO_TAG_SCRIPT, GUMBO_TAG_STYLE, GUMBO_TAG_TEMPLATE}, 0, 1, 0, false};
+    }
+};
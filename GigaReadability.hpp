@@ -0,0 +1,341 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <strings.h>
+#include <gumbo.h>
+#include "GigaDom.hpp"
+#include "GigaPolicy.hpp"
+
+struct ContentCandidate
+{
+    uint32_t node = DomNode::kNone;
+    double score = 0;
+    size_t textLength = 0;
+    double linkDensity = 0;
+};
+
+// Readability-style main content detection over a FlatDom. Text length,
+// commas and link text are summed per subtree in one bottom-up pass (the DOM
+// is in preorder, so walking it backwards visits children before parents).
+// Every paragraph then scores its parent and, at half weight, its
+// grandparent. The block with the best score, scaled down by its link
+// density and adjusted by class/id hints, is the main content. Each pass
+// is linear in the node count.
+class GigaReadability
+{
+public:
+    // Best scoring block; node is DomNode::kNone when no paragraph has
+    // enough text to score.
+    static ContentCandidate best(const FlatDom &dom)
+    {
+        std::vector<ContentCandidate> ranked = candidates(dom, 1);
+        return ranked.empty() ? ContentCandidate() : ranked.front();
+    }
+
+    // Scored blocks, best first; limit 0 keeps them all.
+    static std::vector<ContentCandidate> candidates(const FlatDom &dom, size_t limit = 0)
+    {
+        size_t n = dom.size();
+        std::vector<Totals> totals(n);
+        for (uint32_t i = static_cast<uint32_t>(n); i-- > 0;)
+        {
+            const DomNode &node = dom[i];
+            Totals &own = totals[i];
+            if (node.type == GUMBO_NODE_TEXT || node.type == GUMBO_NODE_CDATA)
+            {
+                std::string_view text = dom.text(i);
+                own.text = static_cast<uint32_t>(text.size());
+                own.commas = static_cast<uint32_t>(std::count(text.begin(), text.end(), ','));
+            }
+            else if (node.type == GUMBO_NODE_ELEMENT && node.tag == GUMBO_TAG_A)
+            {
+                own.links = own.text;
+            }
+
+            if (i != 0 && node.parent != DomNode::kNone && !isExcluded(node))
+            {
+                Totals &parent = totals[node.parent];
+                parent.text += own.text;
+                parent.links += own.links;
+                parent.commas += own.commas;
+            }
+        }
+
+        std::vector<double> scores(n, 0);
+        std::vector<uint32_t> scored;
+        for (uint32_t i = 0; i < n;)
+        {
+            const DomNode &node = dom[i];
+            if (isExcluded(node))
+            {
+                i = node.subtreeEnd;
+                continue;
+            }
+            if (isParagraph(dom, i) && totals[i].text >= kMinParagraph)
+            {
+                double score = 1 + totals[i].commas + std::min(totals[i].text / 100.0, 3.0);
+                uint32_t parent = node.parent;
+                addScore(dom, scores, scored, parent, score);
+                if (parent != DomNode::kNone)
+                    addScore(dom, scores, scored, dom[parent].parent, score / 2);
+            }
+            ++i;
+        }
+
+        std::vector<ContentCandidate> ranked;
+        ranked.reserve(scored.size());
+        for (uint32_t node : scored)
+        {
+            const Totals &total = totals[node];
+            ContentCandidate candidate;
+            candidate.node = node;
+            candidate.textLength = total.text;
+            candidate.linkDensity = total.text ? static_cast<double>(total.links) / total.text : 0;
+            candidate.score = (scores[node] + tagWeight(dom[node].tag) + classWeight(dom, node)) * (1 - candidate.linkDensity);
+            ranked.push_back(candidate);
+        }
+
+        auto better = [](const ContentCandidate &a, const ContentCandidate &b)
+        { return a.score > b.score || (a.score == b.score && a.node < b.node); };
+        if (limit && limit < ranked.size())
+        {
+            std::partial_sort(ranked.begin(), ranked.begin() + limit, ranked.end(), better);
+            ranked.resize(limit);
+        }
+        else
+        {
+            std::sort(ranked.begin(), ranked.end(), better);
+        }
+        return ranked;
+    }
+
+    // Readable text of a subtree: excluded elements are left out, runs of
+    // whitespace collapse to one space and block elements go on their own
+    // lines.
+    static std::string textOf(const FlatDom &dom, uint32_t node)
+    {
+        std::string content;
+        if (node >= dom.size())
+            return content;
+
+        std::vector<uint32_t> blockEnds;
+        bool lineBreak = false;
+        for (uint32_t i = node, end = dom[node].subtreeEnd; i < end;)
+        {
+            while (!blockEnds.empty() && blockEnds.back() <= i)
+            {
+                blockEnds.pop_back();
+                lineBreak = true;
+            }
+
+            const DomNode &current = dom[i];
+            if (isExcluded(current))
+            {
+                i = current.subtreeEnd;
+                continue;
+            }
+            if (current.type == GUMBO_NODE_ELEMENT && isBlock(current.tag))
+            {
+                blockEnds.push_back(current.subtreeEnd);
+                lineBreak = true;
+            }
+            else if (current.type == GUMBO_NODE_TEXT || current.type == GUMBO_NODE_CDATA || current.type == GUMBO_NODE_WHITESPACE)
+            {
+                for (char ch : dom.text(i))
+                {
+                    if (ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r' || ch == '\f')
+                    {
+                        if (!content.empty() && content.back() != ' ' && content.back() != '\n')
+                            content += ' ';
+                        continue;
+                    }
+                    if (lineBreak && !content.empty())
+                    {
+                        if (content.back() == ' ')
+                            content.back() = '\n';
+                        else if (content.back() != '\n')
+                            content += '\n';
+                    }
+                    lineBreak = false;
+                    content += ch;
+                }
+            }
+            ++i;
+        }
+        if (!content.empty() && content.back() == ' ')
+            content.pop_back();
+        return content;
+    }
+
+    // Elements that go on their own line in extracted text.
+    static bool isBlock(uint16_t tag)
+    {
+        switch (tag)
+        {
+        case GUMBO_TAG_P:
+        case GUMBO_TAG_DIV:
+        case GUMBO_TAG_BR:
+        case GUMBO_TAG_LI:
+        case GUMBO_TAG_UL:
+        case GUMBO_TAG_OL:
+        case GUMBO_TAG_DL:
+        case GUMBO_TAG_DT:
+        case GUMBO_TAG_DD:
+        case GUMBO_TAG_H1:
+        case GUMBO_TAG_H2:
+        case GUMBO_TAG_H3:
+        case GUMBO_TAG_H4:
+        case GUMBO_TAG_H5:
+        case GUMBO_TAG_H6:
+        case GUMBO_TAG_PRE:
+        case GUMBO_TAG_BLOCKQUOTE:
+        case GUMBO_TAG_TABLE:
+        case GUMBO_TAG_TR:
+        case GUMBO_TAG_SECTION:
+        case GUMBO_TAG_ARTICLE:
+        case GUMBO_TAG_MAIN:
+        case GUMBO_TAG_FIGURE:
+        case GUMBO_TAG_FIGCAPTION:
+        case GUMBO_TAG_HR:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+private:
+    // Shorter paragraphs are captions, bylines and buttons.
+    static constexpr uint32_t kMinParagraph = 25;
+
+    struct Totals
+    {
+        uint32_t text = 0;
+        uint32_t links = 0;
+        uint32_t commas = 0;
+    };
+
+    static bool isExcluded(const DomNode &node)
+    {
+        static constexpr TagSet excluded{GUMBO_TAG_HEAD, GUMBO_TAG_SCRIPT, GUMBO_TAG_STYLE, GUMBO_TAG_NOSCRIPT,
+                                         GUMBO_TAG_TEMPLATE, GUMBO_TAG_IFRAME, GUMBO_TAG_SVG, GUMBO_TAG_NAV,
+                                         GUMBO_TAG_HEADER, GUMBO_TAG_FOOTER, GUMBO_TAG_ASIDE};
+        return excluded.contains(node.tag);
+    }
+
+    // p, pre and td elements, plus text written straight into a container.
+    static bool isParagraph(const FlatDom &dom, uint32_t index)
+    {
+        const DomNode &node = dom[index];
+        if (node.type == GUMBO_NODE_ELEMENT)
+            return node.tag == GUMBO_TAG_P || node.tag == GUMBO_TAG_PRE || node.tag == GUMBO_TAG_TD;
+        if (node.type != GUMBO_NODE_TEXT || node.parent == DomNode::kNone)
+            return false;
+
+        const DomNode &parent = dom[node.parent];
+        if (parent.type != GUMBO_NODE_ELEMENT)
+            return false;
+        switch (parent.tag)
+        {
+        case GUMBO_TAG_DIV:
+        case GUMBO_TAG_SECTION:
+        case GUMBO_TAG_ARTICLE:
+        case GUMBO_TAG_MAIN:
+        case GUMBO_TAG_BODY:
+        case GUMBO_TAG_BLOCKQUOTE:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    static void addScore(const FlatDom &dom, std::vector<double> &scores, std::vector<uint32_t> &scored, uint32_t node, double score)
+    {
+        if (node == DomNode::kNone || dom[node].type != GUMBO_NODE_ELEMENT)
+            return;
+        if (scores[node] == 0)
+            scored.push_back(node);
+        scores[node] += score;
+    }
+
+    static double tagWeight(uint16_t tag)
+    {
+        switch (tag)
+        {
+        case GUMBO_TAG_ARTICLE:
+        case GUMBO_TAG_MAIN:
+            return 10;
+        case GUMBO_TAG_DIV:
+        case GUMBO_TAG_SECTION:
+            return 5;
+        case GUMBO_TAG_PRE:
+        case GUMBO_TAG_TD:
+        case GUMBO_TAG_BLOCKQUOTE:
+            return 3;
+        case GUMBO_TAG_ADDRESS:
+        case GUMBO_TAG_OL:
+        case GUMBO_TAG_UL:
+        case GUMBO_TAG_DL:
+        case GUMBO_TAG_DD:
+        case GUMBO_TAG_DT:
+        case GUMBO_TAG_LI:
+        case GUMBO_TAG_FORM:
+            return -3;
+        case GUMBO_TAG_H1:
+        case GUMBO_TAG_H2:
+        case GUMBO_TAG_H3:
+        case GUMBO_TAG_H4:
+        case GUMBO_TAG_H5:
+        case GUMBO_TAG_H6:
+        case GUMBO_TAG_TH:
+            return -5;
+        default:
+            return 0;
+        }
+    }
+
+    // +25 / -25 for each of class and id that looks like content / chrome.
+    static double classWeight(const FlatDom &dom, uint32_t node)
+    {
+        static const char *const positive[] = {"article", "body", "content", "entry", "main", "page", "post", "text", "blog", "story"};
+        static const char *const negative[] = {"comment", "combx", "contact", "foot", "masthead", "media", "meta", "promo",
+                                               "related", "share", "sidebar", "sponsor", "widget", "nav", "menu", "banner",
+                                               "advert", "social", "hidden"};
+        double weight = 0;
+        for (const char *name : {"class", "id"})
+        {
+            std::string_view value;
+            if (!dom.attribute(node, name, value) || value.empty())
+                continue;
+            for (const char *word : negative)
+            {
+                if (containsNoCase(value, word))
+                {
+                    weight -= 25;
+                    break;
+                }
+            }
+            for (const char *word : positive)
+            {
+                if (containsNoCase(value, word))
+                {
+                    weight += 25;
+                    break;
+                }
+            }
+        }
+        return weight;
+    }
+
+    static bool containsNoCase(std::string_view haystack, std::string_view needle)
+    {
+        for (size_t i = 0; i + needle.size() <= haystack.size(); ++i)
+        {
+            if (strncasecmp(haystack.data() + i, needle.data(), needle.size()) == 0)
+                return true;
+        }
+        return false;
+    }
+};
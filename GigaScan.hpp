@@ -0,0 +1,215 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+// Byte scanning primitives shared by the tokenizer and the text helpers.
+// findAny() returns the first byte equal to one of up to four characters
+// (unused ones default to the previous character, so NUL cannot be
+// searched). On x86 with GCC or Clang the AVX2 or SSE2 version is picked at
+// runtime; setLevel() can force a narrower one. Other compilers and CPUs get
+// the scalar code.
+class GigaScan
+{
+public:
+    enum class Level
+    {
+        Scalar,
+        SSE2,
+        AVX2
+    };
+
+    static Level detectLevel()
+    {
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            return Level::AVX2;
+        if (__builtin_cpu_supports("sse2"))
+            return Level::SSE2;
+#endif
+        return Level::Scalar;
+    }
+
+    static Level getLevel()
+    {
+        return current();
+    }
+
+    // Never raises the level above what the CPU supports.
+    static void setLevel(Level level)
+    {
+        Level supported = detectLevel();
+        current() = level > supported ? supported : level;
+    }
+
+    static const char *find(const char *p, const char *end, char a)
+    {
+        return findAny(p, end, a, a, a, a);
+    }
+
+    static const char *findAny(const char *p, const char *end, char a, char b, char c = 0, char d = 0)
+    {
+        if (c == 0)
+            c = b;
+        if (d == 0)
+            d = c;
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+        switch (current())
+        {
+        case Level::AVX2:
+            return findAnyAVX2(p, end, a, b, c, d);
+        case Level::SSE2:
+            return findAnySSE2(p, end, a, b, c, d);
+        default:
+            break;
+        }
+#endif
+        return findAnyScalar(p, end, a, b, c, d);
+    }
+
+    // Bit i of the result is set when p[i] is one of a..d, for i < 64 and
+    // p + i < end. Used to build structural bitmaps 64 bytes at a time.
+    static uint64_t matchMask64(const char *p, const char *end, char a, char b, char c, char d)
+    {
+        size_t n = static_cast<size_t>(end - p);
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+        if (n >= 64)
+        {
+            switch (current())
+            {
+            case Level::AVX2:
+                return matchMask64AVX2(p, a, b, c, d);
+            case Level::SSE2:
+                return matchMask64SSE2(p, a, b, c, d);
+            default:
+                break;
+            }
+        }
+#endif
+        uint64_t mask = 0;
+        for (size_t i = 0; i < n && i < 64; ++i)
+        {
+            char ch = p[i];
+            if (ch == a || ch == b || ch == c || ch == d)
+                mask |= uint64_t(1) << i;
+        }
+        return mask;
+    }
+
+    // Number of bytes equal to c in [p, end).
+    static size_t count(const char *p, const char *end, char c)
+    {
+        size_t matches = 0;
+        for (size_t offset = 0; offset < static_cast<size_t>(end - p); offset += 64)
+            matches += countBits(matchMask64(p + offset, end, c, c, c, c));
+        return matches;
+    }
+
+    // Index of the lowest set bit of a non-zero mask.
+    static size_t firstBit(uint64_t mask)
+    {
+#if defined(__GNUC__)
+        return static_cast<size_t>(__builtin_ctzll(mask));
+#else
+        size_t index = 0;
+        for (; !(mask & 1); mask >>= 1)
+            ++index;
+        return index;
+#endif
+    }
+
+    static size_t countBits(uint64_t mask)
+    {
+#if defined(__GNUC__)
+        return static_cast<size_t>(__builtin_popcountll(mask));
+#else
+        size_t bits = 0;
+        for (; mask; mask &= mask - 1)
+            ++bits;
+        return bits;
+#endif
+    }
+
+private:
+    static Level &current()
+    {
+        static Level level = detectLevel();
+        return level;
+    }
+
+    static const char *findAnyScalar(const char *p, const char *end, char a, char b, char c, char d)
+    {
+        for (; p < end; ++p)
+        {
+            char ch = *p;
+            if (ch == a || ch == b || ch == c || ch == d)
+                return p;
+        }
+        return end;
+    }
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+    __attribute__((target("sse2"))) static const char *findAnySSE2(const char *p, const char *end, char a, char b, char c, char d)
+    {
+        const __m128i va = _mm_set1_epi8(a), vb = _mm_set1_epi8(b), vc = _mm_set1_epi8(c), vd = _mm_set1_epi8(d);
+        for (; end - p >= 16; p += 16)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+            __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, va), _mm_cmpeq_epi8(v, vb)),
+                                     _mm_or_si128(_mm_cmpeq_epi8(v, vc), _mm_cmpeq_epi8(v, vd)));
+            unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(m));
+            if (mask)
+                return p + __builtin_ctz(mask);
+        }
+        return findAnyScalar(p, end, a, b, c, d);
+    }
+
+    __attribute__((target("avx2"))) static const char *findAnyAVX2(const char *p, const char *end, char a, char b, char c, char d)
+    {
+        const __m256i va = _mm256_set1_epi8(a), vb = _mm256_set1_epi8(b), vc = _mm256_set1_epi8(c), vd = _mm256_set1_epi8(d);
+        for (; end - p >= 32; p += 32)
+        {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+            __m256i m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, va), _mm256_cmpeq_epi8(v, vb)),
+                                        _mm256_or_si256(_mm256_cmpeq_epi8(v, vc), _mm256_cmpeq_epi8(v, vd)));
+            unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(m));
+            if (mask)
+                return p + __builtin_ctz(mask);
+        }
+        return findAnySSE2(p, end, a, b, c, d);
+    }
+
+    __attribute__((target("sse2"))) static uint64_t matchMask64SSE2(const char *p, char a, char b, char c, char d)
+    {
+        const __m128i va = _mm_set1_epi8(a), vb = _mm_set1_epi8(b), vc = _mm_set1_epi8(c), vd = _mm_set1_epi8(d);
+        uint64_t mask = 0;
+        for (int i = 0; i < 4; ++i)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i * 16));
+            __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, va), _mm_cmpeq_epi8(v, vb)),
+                                     _mm_or_si128(_mm_cmpeq_epi8(v, vc), _mm_cmpeq_epi8(v, vd)));
+            mask |= static_cast<uint64_t>(static_cast<unsigned>(_mm_movemask_epi8(m))) << (i * 16);
+        }
+        return mask;
+    }
+
+    __attribute__((target("avx2"))) static uint64_t matchMask64AVX2(const char *p, char a, char b, char c, char d)
+    {
+        const __m256i va = _mm256_set1_epi8(a), vb = _mm256_set1_epi8(b), vc = _mm256_set1_epi8(c), vd = _mm256_set1_epi8(d);
+        uint64_t mask = 0;
+        for (int i = 0; i < 2; ++i)
+        {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i * 32));
+            __m256i m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, va), _mm256_cmpeq_epi8(v, vb)),
+                                        _mm256_or_si256(_mm256_cmpeq_epi8(v, vc), _mm256_cmpeq_epi8(v, vd)));
+            mask |= static_cast<uint64_t>(static_cast<unsigned>(_mm256_movemask_epi8(m))) << (i * 32);
+        }
+        return mask;
+    }
+#endif
+};
@@ -0,0 +1,228 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <functional>
+#include <string>
+#include <unordered_map>
+
+// Per-host limits. Each host has a token bucket (ratePerSecond, burst) and an
+// adaptive concurrency limit that grows additively while responses are fast
+// and shrinks multiplicatively on 429, 5xx, failed connections (status 0) or
+// when latency exceeds targetLatency.
+struct HostPolicy
+{
+    double ratePerSecond = 2.0;
+    double minRatePerSecond = 0.1;
+    double maxRatePerSecond = 20.0;
+    double burst = 4.0;
+    double initialConcurrency = 2.0;
+    double minConcurrency = 1.0;
+    double maxConcurrency = 16.0;
+    double targetLatency = 2.0;
+    double decreaseFactor = 0.5;
+};
+
+struct HostState
+{
+    std::deque<std::string> urls;
+    double tokens = 0.0;
+    double ratePerSecond = 0.0;
+    double concurrency = 0.0;
+    size_t inFlight = 0;
+    size_t completed = 0;
+    size_t throttled = 0; // 429 and 503
+    size_t failed = 0;    // other 5xx and transfers without a response
+    std::chrono::steady_clock::time_point lastRefill;
+    bool scheduled = false;
+};
+
+// Politeness scheduler: URLs are queued per host and pop() hands out the next
+// URL in round-robin order from a host that has both a token and a free
+// concurrency slot. complete() feeds back status and latency for AIMD.
+class GigaScheduler
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using HostKey = std::function<std::string(const std::string &)>;
+
+    explicit GigaScheduler(HostKey hostKey, const HostPolicy &policy = HostPolicy())
+        : hostKey(std::move(hostKey)), policy(policy)
+    {
+    }
+
+    void setPolicy(const HostPolicy &newPolicy)
+    {
+        policy = newPolicy;
+    }
+
+    const HostPolicy &getPolicy() const
+    {
+        return policy;
+    }
+
+    void push(const std::string &url)
+    {
+        std::string name = hostKey(url);
+        HostState &host = stateFor(name);
+        host.urls.push_back(url);
+        ++queuedCount;
+        schedule(name, host);
+    }
+
+    size_t size() const
+    {
+        return queuedCount;
+    }
+
+    bool empty() const
+    {
+        return queuedCount == 0;
+    }
+
+    size_t inFlight() const
+    {
+        return inFlightCount;
+    }
+
+    const std::unordered_map<std::string, HostState> &getHosts() const
+    {
+        return hosts;
+    }
+
+    bool pop(std::string &url)
+    {
+        Clock::time_point now = Clock::now();
+        for (size_t i = 0, n = ready.size(); i < n; ++i)
+        {
+            std::string name = std::move(ready.front());
+            ready.pop_front();
+
+            HostState &host = hosts[name];
+            if (host.urls.empty())
+            {
+                host.scheduled = false;
+                continue;
+            }
+
+            refill(host, now);
+            if (host.tokens >= 1.0 && host.inFlight < slots(host))
+            {
+                url = std::move(host.urls.front());
+                host.urls.pop_front();
+                host.tokens -= 1.0;
+                ++host.inFlight;
+                ++inFlightCount;
+                --queuedCount;
+                if (host.urls.empty())
+                    host.scheduled = false;
+                else
+                    ready.push_back(std::move(name));
+                return true;
+            }
+
+            ready.push_back(std::move(name));
+        }
+        return false;
+    }
+
+    // Time until some queued host may get a token; saturated hosts wait for complete().
+    Clock::duration nextReadyIn(Clock::duration ceiling = std::chrono::milliseconds(1000)) const
+    {
+        Clock::time_point now = Clock::now();
+        Clock::duration best = ceiling;
+        for (const auto &name : ready)
+        {
+            const HostState &host = hosts.at(name);
+            if (host.urls.empty() || host.inFlight >= slots(host))
+                continue;
+
+            double elapsed = std::chrono::duration<double>(now - host.lastRefill).count();
+            double tokens = std::min(policy.burst, host.tokens + elapsed * host.ratePerSecond);
+            if (tokens >= 1.0)
+                return Clock::duration::zero();
+
+            auto wait = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>((1.0 - tokens) / host.ratePerSecond));
+            best = std::min(best, wait);
+        }
+        return best;
+    }
+
+    void complete(const std::string &url, long httpCode, double seconds)
+    {
+        auto it = hosts.find(hostKey(url));
+        if (it == hosts.end())
+            return;
+
+        HostState &host = it->second;
+        if (host.inFlight > 0)
+        {
+            --host.inFlight;
+            --inFlightCount;
+        }
+        ++host.completed;
+
+        bool throttled = httpCode == 429 || httpCode == 503;
+        if (throttled || httpCode == 0 || httpCode >= 500)
+        {
+            ++(throttled ? host.throttled : host.failed);
+            host.concurrency = std::max(policy.minConcurrency, host.concurrency * policy.decreaseFactor);
+            host.ratePerSecond = std::max(policy.minRatePerSecond, host.ratePerSecond * policy.decreaseFactor);
+            host.tokens = std::min(host.tokens, 0.0);
+        }
+        else if (seconds > policy.targetLatency)
+        {
+            host.concurrency = std::max(policy.minConcurrency, host.concurrency * policy.decreaseFactor);
+        }
+        else
+        {
+            host.concurrency = std::min(policy.maxConcurrency, host.concurrency + 1.0 / host.concurrency);
+            host.ratePerSecond = std::min(policy.maxRatePerSecond, host.ratePerSecond + 0.1 / host.ratePerSecond);
+        }
+    }
+
+private:
+    HostKey hostKey;
+    HostPolicy policy;
+    std::unordered_map<std::string, HostState> hosts;
+    std::deque<std::string> ready;
+    size_t queuedCount = 0;
+    size_t inFlightCount = 0;
+
+    HostState &stateFor(const std::string &name)
+    {
+        auto it = hosts.find(name);
+        if (it != hosts.end())
+            return it->second;
+
+        HostState &host = hosts[name];
+        host.tokens = policy.burst;
+        host.ratePerSecond = policy.ratePerSecond;
+        host.concurrency = policy.initialConcurrency;
+        host.lastRefill = Clock::now();
+        return host;
+    }
+
+    void schedule(const std::string &name, HostState &host)
+    {
+        if (host.scheduled)
+            return;
+        host.scheduled = true;
+        ready.push_back(name);
+    }
+
+    void refill(HostState &host, Clock::time_point now) const
+    {
+        double elapsed = std::chrono::duration<double>(now - host.lastRefill).count();
+        host.tokens = std::min(policy.burst, host.tokens + elapsed * host.ratePerSecond);
+        host.lastRefill = now;
+    }
+
+    // Never below one, even with minConcurrency < 1, so a host with queued
+    // URLs can always make progress instead of leaving crawl() spinning.
+    size_t slots(const HostState &host) const
+    {
+        return static_cast<size_t>(std::max({1.0, policy.minConcurrency, std::floor(host.concurrency)}));
+    }
+};
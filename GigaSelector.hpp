@@ -0,0 +1,706 @@
+#pragma once
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <strings.h>
+#include <gumbo.h>
+#include "GigaDom.hpp"
+
+// Compiled CSS selector evaluated against a FlatDom. Supported: type and
+// universal selectors, #id, .class, [attr], [attr=v], [attr~=v], [attr|=v],
+// [attr^=v], [attr$=v], [attr*=v], :nth-child(an+b|odd|even), :first-child,
+// :last-child, the descendant and child (>) combinators and selector lists (,).
+// An unparsable selector is invalid and matches nothing; error() says why.
+class GigaSelector
+{
+public:
+    GigaSelector() = default;
+
+    explicit GigaSelector(std::string_view selector)
+    {
+        Parser parser{selector, 0};
+        if (!parseList(parser))
+        {
+            alternatives.clear();
+            if (errorText.empty())
+                errorText = "unexpected '" + std::string(parser.rest().substr(0, 1)) + "' at " + std::to_string(parser.pos);
+        }
+    }
+
+    bool valid() const
+    {
+        return errorText.empty() && !alternatives.empty();
+    }
+
+    const std::string &error() const
+    {
+        return errorText;
+    }
+
+    bool usesPosition() const
+    {
+        for (const Complex &complex : alternatives)
+            for (const Compound &compound : complex.compounds)
+                if (compound.nth.used || compound.lastChild)
+                    return true;
+        return false;
+    }
+
+    // Bytes of match state step() keeps per node: one per compound.
+    size_t stateSize() const
+    {
+        size_t size = 0;
+        for (const Complex &complex : alternatives)
+            size += complex.compounds.size();
+        return size;
+    }
+
+    // Computes node's match state from its parent's (nullptr for the root)
+    // and returns whether node matches. Byte k of the state records whether
+    // node matches compounds[0..k] of its alternative, and whether node or an
+    // ancestor does, so no ancestor chain is ever searched. position[i] is
+    // node i's 1-based index among its parent's element children; it may be
+    // empty when no compound uses :nth-child.
+    bool step(const FlatDom &dom, uint32_t node, const uint8_t *parent, uint8_t *state, const std::vector<uint32_t> &position = {}) const
+    {
+        bool matched = false;
+        for (const Complex &complex : alternatives)
+        {
+            const size_t count = complex.compounds.size();
+            for (size_t k = 0; k < count; ++k)
+            {
+                uint8_t bits = parent ? (parent[k] & kReached) : 0;
+                bool linked = k == 0 || (parent && (parent[k - 1] & (complex.compounds[k].child ? kMatched : kReached)));
+                if (linked && matchCompound(dom, complex.compounds[k], node, position))
+                    bits = kMatched | kReached;
+                state[k] = bits;
+            }
+            matched = matched || (state[count - 1] & kMatched);
+            if (parent)
+                parent += count;
+            state += count;
+        }
+        return matched;
+    }
+
+    // Whether one node matches; steps down from the root to it.
+    bool matches(const FlatDom &dom, uint32_t node, const std::vector<uint32_t> &position = {}) const
+    {
+        std::vector<uint32_t> path;
+        for (uint32_t i = node; i != DomNode::kNone; i = dom[i].parent)
+            path.push_back(i);
+        const size_t size = stateSize();
+        std::vector<uint8_t> states(2 * size);
+        uint8_t *parent = nullptr;
+        uint8_t *state = states.data();
+        bool matched = false;
+        for (size_t i = path.size(); i-- > 0;)
+        {
+            matched = step(dom, path[i], parent, state, position);
+            parent = state;
+            state = states.data() + (state == states.data() ? size : 0);
+        }
+        return matched;
+    }
+
+    // Matching element indices in document order, in one walk.
+    std::vector<uint32_t> select(const FlatDom &dom) const
+    {
+        std::vector<uint32_t> found;
+        std::vector<uint32_t> position = usesPosition() ? childPositions(dom) : std::vector<uint32_t>();
+        walk(dom, stateSize(), [&](uint32_t node, const uint8_t *parent, uint8_t *state)
+             {
+            if (step(dom, node, parent, state, position))
+                found.push_back(node); });
+        return found;
+    }
+
+    // Calls visit(node, parentState, state) for every node in preorder, with
+    // width bytes of state per node kept on a stack while its subtree is
+    // walked. parentState is nullptr for the root.
+    template <typename Visitor>
+    static void walk(const FlatDom &dom, size_t width, Visitor visit)
+    {
+        std::vector<uint32_t> ends;
+        std::vector<uint8_t> states;
+        for (uint32_t i = 0; i < dom.size(); ++i)
+        {
+            while (!ends.empty() && ends.back() <= i)
+                ends.pop_back();
+            states.resize((ends.size() + 1) * width);
+            uint8_t *state = states.data() + ends.size() * width;
+            visit(i, ends.empty() ? nullptr : state - width, state);
+            ends.push_back(dom[i].subtreeEnd);
+        }
+    }
+
+    static std::vector<uint32_t> childPositions(const FlatDom &dom)
+    {
+        std::vector<uint32_t> position(dom.size(), 0);
+        std::vector<uint32_t> counter(dom.size(), 0);
+        for (uint32_t i = 0; i < dom.size(); ++i)
+        {
+            const DomNode &node = dom[i];
+            if (node.parent != DomNode::kNone && (node.type == GUMBO_NODE_ELEMENT || node.type == GUMBO_NODE_TEMPLATE))
+                position[i] = ++counter[node.parent];
+        }
+        return position;
+    }
+
+private:
+    enum class AttrOp
+    {
+        Exists,
+        Equals,
+        Includes,
+        DashMatch,
+        Prefix,
+        Suffix,
+        Substring
+    };
+
+    struct AttrTest
+    {
+        std::string name;
+        std::string value;
+        AttrOp op = AttrOp::Exists;
+    };
+
+    struct NthTest
+    {
+        bool used = false;
+        int a = 0;
+        int b = 0;
+    };
+
+    struct Compound
+    {
+        GumboTag tag = GUMBO_TAG_LAST; // GUMBO_TAG_LAST: any element
+        std::string tagName;           // for tags Gumbo does not know
+        std::string id;
+        std::vector<std::string> classes;
+        std::vector<AttrTest> attributes;
+        NthTest nth;
+        bool lastChild = false;
+        bool child = false; // joined to the previous compound with '>'
+    };
+
+    struct Complex
+    {
+        std::vector<Compound> compounds;
+    };
+
+    struct Parser
+    {
+        std::string_view text;
+        size_t pos;
+
+        bool done() const { return pos >= text.size(); }
+        char peek() const { return done() ? '\0' : text[pos]; }
+        std::string_view rest() const { return text.substr(std::min(pos, text.size())); }
+
+        bool skipSpace()
+        {
+            size_t start = pos;
+            while (!done() && isspace(static_cast<unsigned char>(text[pos])))
+                ++pos;
+            return pos > start;
+        }
+    };
+
+    static constexpr uint8_t kMatched = 1; // node matches compounds[0..k]
+    static constexpr uint8_t kReached = 2; // node or an ancestor does
+
+    std::vector<Complex> alternatives;
+    std::string errorText;
+
+    static bool isNameChar(char c)
+    {
+        return isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '_' || static_cast<unsigned char>(c) >= 0x80;
+    }
+
+    static std::string parseName(Parser &parser)
+    {
+        std::string name;
+        while (!parser.done())
+        {
+            char c = parser.peek();
+            if (c == '\\' && parser.pos + 1 < parser.text.size())
+            {
+                name.push_back(parser.text[parser.pos + 1]);
+                parser.pos += 2;
+            }
+            else if (isNameChar(c))
+            {
+                name.push_back(c);
+                ++parser.pos;
+            }
+            else
+            {
+                break;
+            }
+        }
+        return name;
+    }
+
+    bool parseList(Parser &parser)
+    {
+        while (true)
+        {
+            parser.skipSpace();
+            Complex complex;
+            if (!parseComplex(parser, complex))
+                return false;
+            alternatives.push_back(std::move(complex));
+            parser.skipSpace();
+            if (parser.done())
+                return true;
+            if (parser.peek() != ',')
+                return false;
+            ++parser.pos;
+        }
+    }
+
+    bool parseComplex(Parser &parser, Complex &complex)
+    {
+        bool child = false;
+        while (true)
+        {
+            Compound compound;
+            compound.child = child;
+            if (!parseCompound(parser, compound))
+                return false;
+            complex.compounds.push_back(std::move(compound));
+
+            bool space = parser.skipSpace();
+            char c = parser.peek();
+            if (c == '>')
+            {
+                ++parser.pos;
+                parser.skipSpace();
+                child = true;
+            }
+            else if (space && c != ',' && !parser.done())
+            {
+                child = false;
+            }
+            else
+            {
+                return true;
+            }
+        }
+    }
+
+    bool parseCompound(Parser &parser, Compound &compound)
+    {
+        size_t start = parser.pos;
+        if (parser.peek() == '*')
+        {
+            ++parser.pos;
+        }
+        else if (isNameChar(parser.peek()) || parser.peek() == '\\')
+        {
+            std::string name = parseName(parser);
+            compound.tag = gumbo_tagn_enum(name.data(), static_cast<unsigned int>(name.size()));
+            if (compound.tag == GUMBO_TAG_UNKNOWN)
+                compound.tagName = name;
+        }
+
+        while (!parser.done())
+        {
+            char c = parser.peek();
+            if (c == '#')
+            {
+                ++parser.pos;
+                compound.id = parseName(parser);
+                if (compound.id.empty())
+                    return false;
+            }
+            else if (c == '.')
+            {
+                ++parser.pos;
+                std::string name = parseName(parser);
+                if (name.empty())
+                    return false;
+                compound.classes.push_back(std::move(name));
+            }
+            else if (c == '[')
+            {
+                ++parser.pos;
+                if (!parseAttribute(parser, compound))
+                    return false;
+            }
+            else if (c == ':')
+            {
+                ++parser.pos;
+                if (!parsePseudo(parser, compound))
+                    return false;
+            }
+            else
+            {
+                break;
+            }
+        }
+        return parser.pos > start;
+    }
+
+    bool parseAttribute(Parser &parser, Compound &compound)
+    {
+        AttrTest test;
+        parser.skipSpace();
+        test.name = parseName(parser);
+        parser.skipSpace();
+        if (test.name.empty())
+            return false;
+
+        char c = parser.peek();
+        if (c == ']')
+        {
+            ++parser.pos;
+            compound.attributes.push_back(std::move(test));
+            return true;
+        }
+
+        switch (c)
+        {
+        case '=':
+            test.op = AttrOp::Equals;
+            break;
+        case '~':
+            test.op = AttrOp::Includes;
+            break;
+        case '|':
+            test.op = AttrOp::DashMatch;
+            break;
+        case '^':
+            test.op = AttrOp::Prefix;
+            break;
+        case '$':
+            test.op = AttrOp::Suffix;
+            break;
+        case '*':
+            test.op = AttrOp::Substring;
+            break;
+        default:
+            return false;
+        }
+        ++parser.pos;
+        if (test.op != AttrOp::Equals)
+        {
+            if (parser.peek() != '=')
+                return false;
+            ++parser.pos;
+        }
+
+        parser.skipSpace();
+        char quote = parser.peek();
+        if (quote == '"' || quote == '\'')
+        {
+            size_t close = parser.text.find(quote, parser.pos + 1);
+            if (close == std::string_view::npos)
+            {
+                errorText = "unterminated string in attribute selector";
+                return false;
+            }
+            test.value = std::string(parser.text.substr(parser.pos + 1, close - parser.pos - 1));
+            parser.pos = close + 1;
+        }
+        else
+        {
+            test.value = parseName(parser);
+        }
+
+        parser.skipSpace();
+        if (parser.peek() != ']')
+            return false;
+        ++parser.pos;
+        compound.attributes.push_back(std::move(test));
+        return true;
+    }
+
+    bool parsePseudo(Parser &parser, Compound &compound)
+    {
+        std::string name = parseName(parser);
+        if (strcasecmp(name.c_str(), "first-child") == 0)
+        {
+            compound.nth = {true, 0, 1};
+            return true;
+        }
+        if (strcasecmp(name.c_str(), "last-child") == 0)
+        {
+            compound.lastChild = true;
+            return true;
+        }
+        if (strcasecmp(name.c_str(), "nth-child") != 0 || parser.peek() != '(')
+        {
+            errorText = "unsupported pseudo-class :" + name;
+            return false;
+        }
+
+        size_t close = parser.text.find(')', parser.pos);
+        if (close == std::string_view::npos)
+            return false;
+        std::string_view argument = parser.text.substr(parser.pos + 1, close - parser.pos - 1);
+        parser.pos = close + 1;
+        if (!parseNth(argument, compound.nth))
+        {
+            errorText = "bad :nth-child argument '" + std::string(argument) + "'";
+            return false;
+        }
+        return true;
+    }
+
+    // an+b, odd, even, or a plain integer.
+    static bool parseNth(std::string_view argument, NthTest &nth)
+    {
+        std::string text;
+        for (char c : argument)
+            if (!isspace(static_cast<unsigned char>(c)))
+                text.push_back(static_cast<char>(tolower(c)));
+
+        nth.used = true;
+        if (text == "odd")
+        {
+            nth.a = 2;
+            nth.b = 1;
+            return true;
+        }
+        if (text == "even")
+        {
+            nth.a = 2;
+            nth.b = 0;
+            return true;
+        }
+
+        size_t n = text.find('n');
+        size_t i = 0;
+        auto number = [&text, &i](int &value, bool allowEmpty) -> bool
+        {
+            int sign = 1;
+            if (i < text.size() && (text[i] == '+' || text[i] == '-'))
+                sign = text[i++] == '-' ? -1 : 1;
+            size_t start = i;
+            value = 0;
+            while (i < text.size() && isdigit(static_cast<unsigned char>(text[i])))
+                value = value * 10 + (text[i++] - '0');
+            if (i == start)
+            {
+                value = sign;
+                return allowEmpty;
+            }
+            value *= sign;
+            return true;
+        };
+
+        if (n == std::string::npos)
+        {
+            nth.a = 0;
+            return number(nth.b, false) && i == text.size();
+        }
+
+        if (!number(nth.a, true) || i != n)
+            return false;
+        ++i;
+        nth.b = 0;
+        if (i == text.size())
+            return true;
+        if (text[i] != '+' && text[i] != '-')
+            return false;
+        return number(nth.b, false) && i == text.size();
+    }
+
+    static bool nameEquals(std::string_view a, std::string_view b)
+    {
+        return a.size() == b.size() && strncasecmp(a.data(), b.data(), a.size()) == 0;
+    }
+
+    static bool hasToken(std::string_view list, std::string_view token)
+    {
+        size_t i = 0;
+        while (i < list.size())
+        {
+            while (i < list.size() && isspace(static_cast<unsigned char>(list[i])))
+                ++i;
+            size_t start = i;
+            while (i < list.size() && !isspace(static_cast<unsigned char>(list[i])))
+                ++i;
+            if (i > start && list.substr(start, i - start) == token)
+                return true;
+        }
+        return false;
+    }
+
+    static bool matchAttribute(const AttrTest &test, std::string_view value)
+    {
+        std::string_view expected = test.value;
+        switch (test.op)
+        {
+        case AttrOp::Exists:
+            return true;
+        case AttrOp::Equals:
+            return value == expected;
+        case AttrOp::Includes:
+            return !expected.empty() && hasToken(value, expected);
+        case AttrOp::DashMatch:
+            return value == expected || (value.size() > expected.size() && value.substr(0, expected.size()) == expected && value[expected.size()] == '-');
+        case AttrOp::Prefix:
+            return !expected.empty() && value.substr(0, expected.size()) == expected;
+        case AttrOp::Suffix:
+            return !expected.empty() && value.size() >= expected.size() && value.substr(value.size() - expected.size()) == expected;
+        case AttrOp::Substring:
+            return !expected.empty() && value.find(expected) != std::string_view::npos;
+        }
+        return false;
+    }
+
+    static uint32_t elementPosition(const FlatDom &dom, uint32_t node, const std::vector<uint32_t> &position)
+    {
+        if (!position.empty())
+            return position[node];
+        uint32_t parent = dom[node].parent;
+        if (parent == DomNode::kNone)
+            return 0;
+        uint32_t index = 0;
+        for (uint32_t child = dom[parent].firstChild; child != DomNode::kNone; child = dom[child].nextSibling)
+        {
+            uint8_t type = dom[child].type;
+            if (type == GUMBO_NODE_ELEMENT || type == GUMBO_NODE_TEMPLATE)
+                ++index;
+            if (child == node)
+                break;
+        }
+        return index;
+    }
+
+    static bool isLastElement(const FlatDom &dom, uint32_t node)
+    {
+        for (uint32_t next = dom[node].nextSibling; next != DomNode::kNone; next = dom[next].nextSibling)
+        {
+            uint8_t type = dom[next].type;
+            if (type == GUMBO_NODE_ELEMENT || type == GUMBO_NODE_TEMPLATE)
+                return false;
+        }
+        return dom[node].parent != DomNode::kNone;
+    }
+
+    static bool matchCompound(const FlatDom &dom, const Compound &compound, uint32_t node, const std::vector<uint32_t> &position)
+    {
+        const DomNode &n = dom[node];
+        if (n.type != GUMBO_NODE_ELEMENT && n.type != GUMBO_NODE_TEMPLATE)
+            return false;
+
+        if (compound.tag != GUMBO_TAG_LAST)
+        {
+            if (n.tag != compound.tag)
+                return false;
+            if (compound.tag == GUMBO_TAG_UNKNOWN && !nameEquals(dom.tagName(node), compound.tagName))
+                return false;
+        }
+
+        std::string_view value;
+        if (!compound.id.empty() && (!dom.attribute(node, "id", value) || value != compound.id))
+            return false;
+
+        if (!compound.classes.empty())
+        {
+            if (!dom.attribute(node, "class", value))
+                return false;
+            for (const std::string &name : compound.classes)
+                if (!hasToken(value, name))
+                    return false;
+        }
+
+        for (const AttrTest &test : compound.attributes)
+        {
+            if (!dom.attribute(node, test.name, value) || !matchAttribute(test, value))
+                return false;
+        }
+
+        if (compound.nth.used)
+        {
+            long index = elementPosition(dom, node, position);
+            if (index == 0)
+                return false;
+            long offset = index - compound.nth.b;
+            if (compound.nth.a == 0)
+            {
+                if (offset != 0)
+                    return false;
+            }
+            else if (offset / compound.nth.a < 0 || offset % compound.nth.a != 0)
+            {
+                return false;
+            }
+        }
+
+        return !compound.lastChild || isLastElement(dom, node);
+    }
+};
+
+// Several compiled selectors evaluated in one walk over the DOM.
+class GigaSelectorSet
+{
+public:
+    // Returns the id used to index select()'s result.
+    size_t add(GigaSelector selector)
+    {
+        selectors.push_back(std::move(selector));
+        return selectors.size() - 1;
+    }
+
+    size_t add(std::string_view selector)
+    {
+        return add(GigaSelector(selector));
+    }
+
+    size_t size() const
+    {
+        return selectors.size();
+    }
+
+    const GigaSelector &operator[](size_t id) const
+    {
+        return selectors[id];
+    }
+
+    // visit(id, node) for every match, in document order.
+    template <typename Visitor>
+    void forEachMatch(const FlatDom &dom, Visitor visit) const
+    {
+        bool positions = false;
+        for (const GigaSelector &selector : selectors)
+            positions = positions || selector.usesPosition();
+        std::vector<uint32_t> position = positions ? GigaSelector::childPositions(dom) : std::vector<uint32_t>();
+
+        std::vector<size_t> offsets;
+        size_t width = 0;
+        for (const GigaSelector &selector : selectors)
+        {
+            offsets.push_back(width);
+            width += selector.stateSize();
+        }
+
+        GigaSelector::walk(dom, width, [&](uint32_t node, const uint8_t *parent, uint8_t *state)
+                           {
+            for (size_t id = 0; id < selectors.size(); ++id)
+            {
+                if (selectors[id].step(dom, node, parent ? parent + offsets[id] : nullptr, state + offsets[id], position))
+                    visit(id, node);
+            } });
+    }
+
+    // result[id] lists the nodes matched by selector id.
+    std::vector<std::vector<uint32_t>> select(const FlatDom &dom) const
+    {
+        std::vector<std::vector<uint32_t>> found(selectors.size());
+        forEachMatch(dom, [&found](size_t id, uint32_t node)
+                     { found[id].push_back(node); });
+        return found;
+    }
+
+private:
+    std::vector<GigaSelector> selectors;
+};
@@ -0,0 +1,148 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <ctime>
+#include <curl/curl.h>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "GigaCurl.hpp"
+
+// Shared libcurl state (DNS cache, TLS sessions and optionally the connection
+// cache) for several GigaFetcher instances, typically one fetcher per worker
+// thread. libcurl serializes access through the lock callbacks below.
+class GigaShare
+{
+public:
+    // libcurl documents connection-cache sharing as unsupported between
+    // concurrently running threads, so it is opt-in.
+    explicit GigaShare(bool shareConnections = false)
+    {
+        gigaCurlGlobalInit();
+        share = curl_share_init();
+        curl_share_setopt(share, CURLSHOPT_LOCKFUNC, LockCallback);
+        curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, UnlockCallback);
+        curl_share_setopt(share, CURLSHOPT_USERDATA, this);
+        curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+        if (shareConnections)
+            curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+    }
+
+    ~GigaShare()
+    {
+        curl_share_cleanup(share);
+    }
+
+    GigaShare(const GigaShare &) = delete;
+    GigaShare &operator=(const GigaShare &) = delete;
+
+    CURLSH *handle() const
+    {
+        return share;
+    }
+
+    // Writes the cached TLS sessions (tickets) so a restarted crawl can resume
+    // them. Needs libcurl 8.12 or newer built with SSL session export; returns
+    // false otherwise.
+    bool saveSessions(const std::string &path)
+    {
+#if LIBCURL_VERSION_NUM >= 0x080c00
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file)
+            return false;
+
+        CURL *curl = curl_easy_init();
+        if (!curl)
+            return false;
+        curl_easy_setopt(curl, CURLOPT_SHARE, share);
+        CURLcode res = curl_easy_ssls_export(curl, ExportCallback, &file);
+        curl_easy_cleanup(curl);
+        return res == CURLE_OK && file.good();
+#else
+        (void)path;
+        return false;
+#endif
+    }
+
+    // Imports sessions written by saveSessions(), skipping expired ones.
+    // Returns the number of sessions imported.
+    size_t loadSessions(const std::string &path)
+    {
+        size_t imported = 0;
+#if LIBCURL_VERSION_NUM >= 0x080c00
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+            return 0;
+
+        CURL *curl = curl_easy_init();
+        if (!curl)
+            return 0;
+        curl_easy_setopt(curl, CURLOPT_SHARE, share);
+
+        std::string key, shmac, sdata;
+        int64_t validUntil = 0;
+        while (readField(file, key) && readField(file, shmac) && readField(file, sdata) &&
+               file.read(reinterpret_cast<char *>(&validUntil), sizeof(validUntil)))
+        {
+            if (validUntil > 0 && validUntil < static_cast<int64_t>(std::time(nullptr)))
+                continue;
+            if (curl_easy_ssls_import(curl, key.empty() ? nullptr : key.c_str(),
+                                      reinterpret_cast<const unsigned char *>(shmac.data()), shmac.size(),
+                                      reinterpret_cast<const unsigned char *>(sdata.data()), sdata.size()) == CURLE_OK)
+                ++imported;
+        }
+        curl_easy_cleanup(curl);
+#else
+        (void)path;
+#endif
+        return imported;
+    }
+
+private:
+    CURLSH *share = nullptr;
+    std::array<std::mutex, CURL_LOCK_DATA_LAST> locks;
+
+    static void LockCallback(CURL *, curl_lock_data data, curl_lock_access, void *userptr)
+    {
+        static_cast<GigaShare *>(userptr)->locks[data].lock();
+    }
+
+    static void UnlockCallback(CURL *, curl_lock_data data, void *userptr)
+    {
+        static_cast<GigaShare *>(userptr)->locks[data].unlock();
+    }
+
+    static void writeField(std::ofstream &file, const void *data, size_t length)
+    {
+        uint32_t size = static_cast<uint32_t>(length);
+        file.write(reinterpret_cast<const char *>(&size), sizeof(size));
+        file.write(static_cast<const char *>(data), size);
+    }
+
+    static bool readField(std::ifstream &file, std::string &field)
+    {
+        uint32_t size = 0;
+        if (!file.read(reinterpret_cast<char *>(&size), sizeof(size)))
+            return false;
+        field.resize(size);
+        return size == 0 || static_cast<bool>(file.read(&field[0], size));
+    }
+
+#if LIBCURL_VERSION_NUM >= 0x080c00
+    static CURLcode ExportCallback(CURL *, void *userptr, const char *sessionKey,
+                                   const unsigned char *shmac, size_t shmacLength,
+                                   const unsigned char *sdata, size_t sdataLength,
+                                   curl_off_t validUntil, int, const char *, size_t)
+    {
+        std::ofstream &file = *static_cast<std::ofstream *>(userptr);
+        writeField(file, sessionKey, sessionKey ? std::char_traits<char>::length(sessionKey) : 0);
+        writeField(file, shmac, shmacLength);
+        writeField(file, sdata, sdataLength);
+        int64_t expires = static_cast<int64_t>(validUntil);
+        file.write(reinterpret_cast<const char *>(&expires), sizeof(expires));
+        return file.good() ? CURLE_OK : CURLE_WRITE_ERROR;
+    }
+#endif
+};
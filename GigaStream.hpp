@@ -0,0 +1,169 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <string_view>
+#include "GigaEntities.hpp"
+#include "GigaFetcher.hpp"
+#include "GigaTokenizer.hpp"
+
+// Callbacks of GigaStreamParser. Every member is optional. Views are only
+// valid during the call. Text arrives decoded and may be split across
+// several onText calls; raw is set for script/style contents. Comments and
+// CDATA sections may likewise arrive in several onComment calls.
+struct GigaStreamHandler
+{
+    std::function<void(const HtmlToken &)> onStartTag;
+    std::function<void(const HtmlToken &, std::string_view name, std::string_view value)> onAttribute;
+    std::function<void(const HtmlToken &)> onEndTag;
+    std::function<void(std::string_view text, bool raw)> onText;
+    std::function<void(std::string_view comment)> onComment;
+};
+
+// Incremental SAX-style parser: feed() it chunks as they arrive (for example
+// straight from GigaFetcher's body callback) and it reports tokens as soon as
+// they are complete. Only an unfinished tag, doctype or character reference
+// is buffered between chunks, and the tokenizer resumes its scan where the
+// previous chunk ended, so each byte is examined a bounded number of times
+// and memory stays around the chunk size regardless of the page size.
+class GigaStreamParser
+{
+public:
+    explicit GigaStreamParser(GigaStreamHandler handler) : handler(std::move(handler)), tokenizer(std::string_view())
+    {
+    }
+
+    // Returns false once stop() was called, which aborts a transfer when used
+    // as a body callback.
+    bool feed(const char *data, size_t length)
+    {
+        if (stopped)
+            return false;
+        bytesFed += length;
+        if (pending.empty())
+        {
+            size_t used = parse(std::string_view(data, length), true);
+            pending.assign(data + used, length - used);
+        }
+        else
+        {
+            pending.append(data, length);
+            size_t used = parse(pending, true);
+            pending.erase(0, used);
+        }
+        return !stopped;
+    }
+
+    bool feed(std::string_view chunk)
+    {
+        return feed(chunk.data(), chunk.size());
+    }
+
+    // Flushes whatever is buffered as end of input; the parser can then be reused.
+    void finish()
+    {
+        if (!stopped)
+            parse(pending, false);
+        pending.clear();
+        tokenizer = GigaTokenizer(std::string_view());
+        stopped = false;
+    }
+
+    void stop()
+    {
+        stopped = true;
+    }
+
+    bool isStopped() const
+    {
+        return stopped;
+    }
+
+    size_t getBytesFed() const
+    {
+        return bytesFed;
+    }
+
+    size_t getBuffered() const
+    {
+        return pending.size();
+    }
+
+    GigaFetcher::BodyCallback bodyCallback()
+    {
+        return [this](const char *data, size_t length)
+        { return feed(data, length); };
+    }
+
+private:
+    GigaStreamHandler handler;
+    GigaTokenizer tokenizer;
+    std::string pending;
+    std::string decoded;
+    size_t bytesFed = 0;
+    bool stopped = false;
+
+    size_t parse(std::string_view input, bool more)
+    {
+        tokenizer.resume(input, more);
+        HtmlToken token;
+        while (!stopped && tokenizer.next(token))
+            dispatch(token);
+        return stopped ? input.size() : tokenizer.consumed();
+    }
+
+    void dispatch(const HtmlToken &token)
+    {
+        switch (token.type)
+        {
+        case HtmlTokenType::Text:
+            if (!handler.onText || token.text.empty())
+                break;
+            if (!token.rawText && token.text.find('&') != std::string_view::npos)
+            {
+                decoded.clear();
+                GigaEntities::decode(token.text, decoded);
+                handler.onText(decoded, false);
+            }
+            else
+            {
+                handler.onText(token.text, token.rawText);
+            }
+            break;
+
+        case HtmlTokenType::StartTag:
+            if (handler.onStartTag)
+                handler.onStartTag(token);
+            if (handler.onAttribute)
+            {
+                std::string_view rest = token.attributes, name, value;
+                while (!stopped && GigaTokenizer::nextAttribute(rest, name, value))
+                {
+                    if (value.find('&') != std::string_view::npos)
+                    {
+                        decoded.clear();
+                        GigaEntities::decode(value, decoded, true);
+                        handler.onAttribute(token, name, decoded);
+                    }
+                    else
+                    {
+                        handler.onAttribute(token, name, value);
+                    }
+                }
+            }
+            break;
+
+        case HtmlTokenType::EndTag:
+            if (handler.onEndTag)
+                handler.onEndTag(token);
+            break;
+
+        case HtmlTokenType::Comment:
+            if (handler.onComment)
+                handler.onComment(token.text);
+            break;
+
+        case HtmlTokenType::Doctype:
+            break;
+        }
+    }
+};
@@ -0,0 +1,654 @@
+#pragma once
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <strings.h>
+#include <gumbo.h>
+#include "GigaDom.hpp"
+#include "GigaEntities.hpp"
+#include "GigaScan.hpp"
+
+enum class HtmlTokenType
+{
+    Text,
+    StartTag,
+    EndTag,
+    Comment,
+    Doctype
+};
+
+// Views into the input; nothing is copied or decoded. For tags, text is the
+// whole "<...>" and attributes the raw region after the name.
+struct HtmlToken
+{
+    HtmlTokenType type = HtmlTokenType::Text;
+    std::string_view text;
+    std::string_view name;
+    std::string_view attributes;
+    GumboTag tag = GUMBO_TAG_UNKNOWN;
+    bool selfClosing = false;
+    bool rawText = false; // contents of script/style-like elements: no entities, no markup
+};
+
+// Extraction-oriented HTML tokenizer. It follows the HTML5 tokenizer closely
+// enough for text extraction (comments, raw text and RCDATA elements, quoted
+// attribute values containing '>') but builds no spec tree; toFlatDom() nests
+// elements by matching end tags, which is what the content extractors need.
+class GigaTokenizer
+{
+public:
+    explicit GigaTokenizer(std::string_view html) : begin(html.data()), pos(html.data()), end(html.data() + html.size())
+    {
+    }
+
+    // Continues on a new buffer, keeping the raw text state. With more set,
+    // next() stops before a construct that may continue in later input, and
+    // long text runs and comments are returned in pieces; consumed() tells
+    // how much of the buffer was used, the rest must be passed again at the
+    // start of the next input.
+    void resume(std::string_view html, bool moreInput)
+    {
+        begin = pos = html.data();
+        end = html.data() + html.size();
+        more = moreInput;
+    }
+
+    size_t consumed() const
+    {
+        return static_cast<size_t>(pos - begin);
+    }
+
+    bool next(HtmlToken &token)
+    {
+        token = HtmlToken();
+        if (pos >= end)
+            return false;
+
+        if (!rawEnd.empty())
+            return rawTextToken(token);
+        if (!commentEnd.empty())
+            return commentToken(token, pos, commentEnd);
+
+        if (*pos != '<')
+            return textToken(token, pos + 1);
+
+        const char *p = pos + 1;
+        if (more && end - pos < 3)
+            return false;
+        if (p < end && *p == '!')
+            return markupDeclaration(token);
+        if (p < end && *p == '/')
+            return endTag(token);
+        if (p < end && *p == '?')
+            return bogusComment(token, p);
+        if (p < end && isalpha(static_cast<unsigned char>(*p)))
+            return startTag(token);
+
+        return textToken(token, p);
+    }
+
+    // Iterates name/value pairs of HtmlToken::attributes. Values are raw
+    // (quotes stripped, entities not decoded).
+    static bool nextAttribute(std::string_view &rest, std::string_view &name, std::string_view &value)
+    {
+        size_t i = 0;
+        while (i < rest.size() && (isSpace(rest[i]) || rest[i] == '/'))
+            ++i;
+        if (i >= rest.size())
+        {
+            rest = {};
+            return false;
+        }
+
+        size_t nameStart = i;
+        while (i < rest.size() && !isSpace(rest[i]) && rest[i] != '/' && rest[i] != '=')
+            ++i;
+        name = rest.substr(nameStart, i - nameStart);
+        value = {};
+
+        size_t j = i;
+        while (j < rest.size() && isSpace(rest[j]))
+            ++j;
+        if (j < rest.size() && rest[j] == '=')
+        {
+            ++j;
+            while (j < rest.size() && isSpace(rest[j]))
+                ++j;
+            if (j < rest.size() && (rest[j] == '"' || rest[j] == '\''))
+            {
+                size_t close = rest.find(rest[j], j + 1);
+                if (close == std::string_view::npos)
+                    close = rest.size();
+                value = rest.substr(j + 1, close - j - 1);
+                i = close < rest.size() ? close + 1 : close;
+            }
+            else
+            {
+                size_t valueStart = j;
+                while (j < rest.size() && !isSpace(rest[j]) && rest[j] != '>')
+                    ++j;
+                value = rest.substr(valueStart, j - valueStart);
+                i = j;
+            }
+        }
+
+        rest = rest.substr(i);
+        return !name.empty();
+    }
+
+    static bool isWhitespace(std::string_view text)
+    {
+        for (char c : text)
+            if (!isSpace(c))
+                return false;
+        return true;
+    }
+
+    static bool isVoidElement(GumboTag tag)
+    {
+        switch (tag)
+        {
+        case GUMBO_TAG_AREA:
+        case GUMBO_TAG_BASE:
+        case GUMBO_TAG_BR:
+        case GUMBO_TAG_COL:
+        case GUMBO_TAG_EMBED:
+        case GUMBO_TAG_HR:
+        case GUMBO_TAG_IMG:
+        case GUMBO_TAG_IMAGE:
+        case GUMBO_TAG_INPUT:
+        case GUMBO_TAG_KEYGEN:
+        case GUMBO_TAG_LINK:
+        case GUMBO_TAG_META:
+        case GUMBO_TAG_PARAM:
+        case GUMBO_TAG_SOURCE:
+        case GUMBO_TAG_TRACK:
+        case GUMBO_TAG_WBR:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    // Builds a flat DOM straight from the token stream. Adjacent text is
+    // merged into one node and decoded; whitespace-only text becomes a
+    // GUMBO_NODE_WHITESPACE node as in Gumbo.
+    static FlatDom toFlatDom(std::string_view html)
+    {
+        FlatDom dom(html);
+        if (!FlatDom::fits(html))
+        {
+            dom.finish();
+            return dom;
+        }
+        std::vector<OpenTag> open;
+        std::string decoded;
+        const char *textBegin = nullptr;
+        const char *textEnd = nullptr;
+        bool textRaw = false;
+
+        auto flushText = [&]()
+        {
+            if (!textBegin)
+                return;
+            std::string_view text(textBegin, static_cast<size_t>(textEnd - textBegin));
+            GumboNodeType type = isWhitespace(text) ? GUMBO_NODE_WHITESPACE : GUMBO_NODE_TEXT;
+            if (!textRaw && text.find('&') != std::string_view::npos)
+            {
+                decoded.clear();
+                GigaEntities::decode(text, decoded);
+                dom.addNode(type, decoded);
+            }
+            else
+            {
+                dom.addNode(type, text);
+            }
+            textBegin = nullptr;
+        };
+
+        auto closeTo = [&](size_t depth)
+        {
+            while (open.size() > depth)
+            {
+                dom.endElement();
+                open.pop_back();
+            }
+        };
+
+        GigaTokenizer tokenizer(html);
+        HtmlToken token;
+        while (tokenizer.next(token))
+        {
+            switch (token.type)
+            {
+            case HtmlTokenType::Text:
+                if (textBegin && textEnd == token.text.data() && textRaw == token.rawText)
+                {
+                    textEnd += token.text.size();
+                }
+                else
+                {
+                    flushText();
+                    textBegin = token.text.data();
+                    textEnd = textBegin + token.text.size();
+                    textRaw = token.rawText;
+                }
+                break;
+
+            case HtmlTokenType::StartTag:
+            {
+                flushText();
+                if (!open.empty() && closesSibling(open.back().tag, token.tag))
+                    closeTo(open.size() - 1);
+
+                dom.beginElement(token.tag, token.tag == GUMBO_TAG_UNKNOWN ? token.name : std::string_view());
+                std::string_view rest = token.attributes, name, value;
+                while (nextAttribute(rest, name, value))
+                {
+                    if (value.find('&') != std::string_view::npos)
+                    {
+                        decoded.clear();
+                        GigaEntities::decode(value, decoded, true);
+                        dom.addAttribute(name, decoded);
+                    }
+                    else
+                    {
+                        dom.addAttribute(name, value);
+                    }
+                }
+
+                if (isVoidElement(token.tag) || (token.selfClosing && token.tag == GUMBO_TAG_UNKNOWN))
+                    dom.endElement();
+                else
+                    open.push_back({token.tag, token.name});
+                break;
+            }
+
+            case HtmlTokenType::EndTag:
+                flushText();
+                for (size_t i = open.size(); i > 0; --i)
+                {
+                    if (open[i - 1].matches(token))
+                    {
+                        closeTo(i - 1);
+                        break;
+                    }
+                }
+                break;
+
+            case HtmlTokenType::Comment:
+                flushText();
+                dom.addNode(GUMBO_NODE_COMMENT, token.text);
+                break;
+
+            case HtmlTokenType::Doctype:
+                flushText();
+                break;
+            }
+        }
+
+        flushText();
+        dom.finish();
+        return dom;
+    }
+
+private:
+    struct OpenTag
+    {
+        GumboTag tag;
+        std::string_view name;
+
+        bool matches(const HtmlToken &token) const
+        {
+            if (tag != token.tag)
+                return false;
+            return tag != GUMBO_TAG_UNKNOWN ||
+                   (name.size() == token.name.size() && strncasecmp(name.data(), token.name.data(), name.size()) == 0);
+        }
+    };
+
+    const char *begin;
+    const char *pos;
+    const char *end;
+    std::string rawEnd;          // name of the open raw text element
+    std::string_view commentEnd; // terminator of a comment reported in pieces
+    bool rawDecoded = false;
+    bool more = false;
+
+    // How far next() got into the construct at pos before running out of
+    // input, as offsets from pos. The unconsumed input comes back at the
+    // start of the next buffer, so the scan continues there instead of
+    // starting over at '<' on every chunk.
+    struct Partial
+    {
+        size_t name = 0;    // end of the tag name scanned so far
+        size_t scanned = 0; // bytes searched for the end of the construct
+        char quote = 0;     // quote of an attribute value open at scanned
+    };
+    Partial partial;
+
+    static bool isSpace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f';
+    }
+
+    static std::string_view view(const char *from, const char *to)
+    {
+        return std::string_view(from, static_cast<size_t>(to - from));
+    }
+
+    // Elements whose start tag implicitly closes an open element of the same
+    // kind (<p><p>, <li><li>, table cells and rows).
+    static bool closesSibling(GumboTag open, GumboTag next)
+    {
+        switch (next)
+        {
+        case GUMBO_TAG_P:
+        case GUMBO_TAG_LI:
+        case GUMBO_TAG_OPTION:
+        case GUMBO_TAG_TR:
+            return open == next;
+        case GUMBO_TAG_DT:
+        case GUMBO_TAG_DD:
+            return open == GUMBO_TAG_DT || open == GUMBO_TAG_DD;
+        case GUMBO_TAG_TD:
+        case GUMBO_TAG_TH:
+            return open == GUMBO_TAG_TD || open == GUMBO_TAG_TH;
+        default:
+            return false;
+        }
+    }
+
+    // Text up to the next '<' from p. When more input may follow, a run
+    // reaching the end is cut before a trailing, possibly partial, reference.
+    bool textToken(HtmlToken &token, const char *p)
+    {
+        const char *stop = GigaScan::find(p, end, '<');
+        if (stop == end && more)
+        {
+            stop = referenceCut(stop);
+            if (stop == pos)
+                return false;
+        }
+        token.text = view(pos, stop);
+        pos = stop;
+        return true;
+    }
+
+    // Moves stop back before a '&' in the last bytes that is not followed by
+    // ';', so a reference split between two inputs is decoded in one piece.
+    const char *referenceCut(const char *stop) const
+    {
+        const char *window = stop - std::min<ptrdiff_t>(stop - pos, 32);
+        for (const char *q = stop; q > window; --q)
+        {
+            if (q[-1] == ';')
+                break;
+            if (q[-1] == '&')
+                return q - 1;
+        }
+        return stop;
+    }
+
+    bool rawTextToken(HtmlToken &token)
+    {
+        const char *p = pos;
+        bool closed = false;
+        while (true)
+        {
+            p = GigaScan::find(p, end, '<');
+            if (p >= end)
+                break;
+            const char *name = p + 2;
+            if (more && name + rawEnd.size() >= end)
+                break;
+            if (p + 1 < end && p[1] == '/' && name + rawEnd.size() <= end &&
+                strncasecmp(name, rawEnd.data(), rawEnd.size()) == 0 &&
+                (name + rawEnd.size() == end || isSpace(name[rawEnd.size()]) || name[rawEnd.size()] == '/' || name[rawEnd.size()] == '>'))
+            {
+                closed = true;
+                break;
+            }
+            ++p;
+        }
+
+        // Without the end tag yet, keep a '<' that may start it for later.
+        if (!closed && more && rawDecoded)
+            p = referenceCut(p);
+        if (p == pos && !closed)
+            return false;
+
+        token.type = HtmlTokenType::Text;
+        token.text = view(pos, p);
+        token.rawText = !rawDecoded;
+        pos = p;
+        if (closed || !more)
+            rawEnd.clear();
+        if (token.text.empty())
+            return next(token);
+        return true;
+    }
+
+    bool markupDeclaration(HtmlToken &token)
+    {
+        const char *p = pos + 2;
+        if (more && end - p < 7)
+            return false;
+        if (end - p >= 2 && p[0] == '-' && p[1] == '-')
+        {
+            // "<!-->" and "<!--->" are complete, empty comments.
+            size_t abrupt = end - p >= 3 && p[2] == '>' ? 3 : end - p >= 4 && p[2] == '-' && p[3] == '>' ? 4 : 0;
+            if (abrupt)
+            {
+                token.type = HtmlTokenType::Comment;
+                token.text = view(p + 2, p + 2);
+                pos = p + abrupt;
+                return true;
+            }
+            return commentToken(token, p + 2, "-->");
+        }
+        // CDATA (foreign content and XHTML pages) runs to "]]>" and is
+        // reported as a comment.
+        if (end - p >= 7 && std::memcmp(p, "[CDATA[", 7) == 0)
+            return commentToken(token, p + 7, "]]>");
+        if (end - p >= 7 && strncasecmp(p, "doctype", 7) == 0)
+        {
+            const char *stop = closingBracket(p);
+            if (stop == end && more)
+                return false;
+            token.type = HtmlTokenType::Doctype;
+            token.text = view(pos, stop);
+            pos = stop == end ? end : stop + 1;
+            return true;
+        }
+        return bogusComment(token, p);
+    }
+
+    // Comment or CDATA text from 'from' to terminator. When the terminator is
+    // not in view and more input follows, the text so far is reported now,
+    // minus a possibly split terminator, and the rest arrives in later
+    // tokens; a long comment is never buffered whole.
+    bool commentToken(HtmlToken &token, const char *from, std::string_view terminator)
+    {
+        token.type = HtmlTokenType::Comment;
+        std::string_view rest = view(from, end);
+        size_t close = rest.find(terminator);
+        if (close != std::string_view::npos || !more)
+        {
+            const char *stop = close == std::string_view::npos ? end : from + close;
+            token.text = view(from, stop);
+            pos = stop == end ? end : stop + terminator.size();
+            commentEnd = {};
+            return true;
+        }
+
+        const char *stop = end - std::min(rest.size(), terminator.size() - 1);
+        commentEnd = terminator;
+        pos = stop;
+        if (stop == from)
+            return false;
+        token.text = view(from, stop);
+        return true;
+    }
+
+    // The '>' ending a doctype or bogus comment, resuming a search that ran
+    // out of input.
+    const char *closingBracket(const char *p)
+    {
+        Partial resume = std::exchange(partial, Partial());
+        const char *stop = GigaScan::find(std::max(p, pos + resume.scanned), end, '>');
+        if (stop == end && more)
+            partial.scanned = static_cast<size_t>(end - pos);
+        return stop;
+    }
+
+    bool bogusComment(HtmlToken &token, const char *p)
+    {
+        const char *stop = closingBracket(p);
+        if (stop == end && more)
+            return false;
+        token.type = HtmlTokenType::Comment;
+        token.text = view(p, stop);
+        pos = stop == end ? end : stop + 1;
+        return true;
+    }
+
+    // End of the tag name starting at p.
+    const char *tagNameEnd(const char *p, const Partial &resume) const
+    {
+        const char *q = std::max(p, pos + resume.name);
+        while (q < end && !isSpace(*q) && *q != '/' && *q != '>')
+            ++q;
+        return q;
+    }
+
+    // Finds the '>' closing a tag whose name ends at start, skipping quoted
+    // attribute values. A quote only opens a value right after '=' (spaces
+    // allowed); elsewhere, as in alt=Bob's or a"b, it is an ordinary
+    // character. Running out of input saves the position in partial.
+    const char *tagEnd(const char *start, const Partial &resume)
+    {
+        const char *p = std::max(start, pos + resume.scanned);
+        char quote = resume.quote;
+        while (true)
+        {
+            if (quote)
+            {
+                const char *close = GigaScan::find(p, end, quote);
+                if (close >= end)
+                {
+                    p = end;
+                    break;
+                }
+                p = close + 1;
+                quote = 0;
+            }
+
+            p = GigaScan::findAny(p, end, '>', '"', '\'');
+            if (p >= end)
+                break;
+            if (*p == '>')
+                return p;
+
+            const char *before = p;
+            while (before > start && isSpace(before[-1]))
+                --before;
+            if (before != start && before[-1] == '=')
+                quote = *p;
+            ++p;
+        }
+        if (more)
+            partial = {static_cast<size_t>(start - pos), static_cast<size_t>(end - pos), quote};
+        return end;
+    }
+
+    bool endTag(HtmlToken &token)
+    {
+        const char *p = pos + 2;
+        if (p >= end)
+        {
+            if (more)
+                return false;
+            token.text = view(pos, end);
+            pos = end;
+            return true;
+        }
+        if (*p == '>')
+        {
+            pos = p + 1;
+            return pos < end ? next(token) : false;
+        }
+        if (!isalpha(static_cast<unsigned char>(*p)))
+            return bogusComment(token, p);
+
+        Partial resume = std::exchange(partial, Partial());
+        const char *nameEnd = tagNameEnd(p, resume);
+        const char *stop = tagEnd(nameEnd, resume);
+        if (stop >= end)
+        {
+            if (!more)
+                pos = end;
+            return false;
+        }
+
+        token.type = HtmlTokenType::EndTag;
+        token.name = view(p, nameEnd);
+        token.tag = gumbo_tagn_enum(token.name.data(), static_cast<unsigned int>(token.name.size()));
+        token.text = view(pos, stop + 1);
+        pos = stop + 1;
+        return true;
+    }
+
+    bool startTag(HtmlToken &token)
+    {
+        const char *p = pos + 1;
+        Partial resume = std::exchange(partial, Partial());
+        const char *nameEnd = tagNameEnd(p, resume);
+        const char *stop = tagEnd(nameEnd, resume);
+        if (stop >= end)
+        {
+            if (!more)
+                pos = end;
+            return false;
+        }
+
+        token.type = HtmlTokenType::StartTag;
+        token.name = view(p, nameEnd);
+        token.tag = gumbo_tagn_enum(token.name.data(), static_cast<unsigned int>(token.name.size()));
+        token.attributes = view(nameEnd, stop);
+        token.selfClosing = stop > nameEnd && stop[-1] == '/';
+        token.text = view(pos, stop + 1);
+        pos = stop + 1;
+
+        switch (token.tag)
+        {
+        case GUMBO_TAG_SCRIPT:
+        case GUMBO_TAG_STYLE:
+        case GUMBO_TAG_XMP:
+        case GUMBO_TAG_IFRAME:
+        case GUMBO_TAG_NOEMBED:
+        case GUMBO_TAG_NOFRAMES:
+            rawEnd = token.name;
+            rawDecoded = false;
+            break;
+        case GUMBO_TAG_TEXTAREA:
+        case GUMBO_TAG_TITLE:
+            rawEnd = token.name;
+            rawDecoded = true;
+            break;
+        case GUMBO_TAG_PLAINTEXT:
+            rawEnd = "\x01";
+            rawDecoded = false;
+            break;
+        default:
+            break;
+        }
+        return true;
+    }
+};
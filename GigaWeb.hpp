@@ -1,4 +1,5 @@
 #include <cstring>
+#include <strings.h>
 #include <unordered_set>
 #include <iostream>
 #include <stdio.h>
@@ -11,77 +12,489 @@
 #include <unordered_map>
 #include <map>
 #include <string_view>
-#include "knownEntities.hpp"
 #include <utility>
 #include <gumbo.h>
+#include "GigaArena.hpp"
+#include "GigaDom.hpp"
+#include "GigaEntities.hpp"
+#include "GigaExtract.hpp"
+#include "GigaFetcher.hpp"
+#include "GigaIndex.hpp"
+#include "GigaPolicy.hpp"
+#include "GigaReadability.hpp"
+#include "GigaScan.hpp"
+#include "GigaScheduler.hpp"
+#include "GigaSelector.hpp"
+#include "GigaStream.hpp"
+#include "GigaMetrics.hpp"
+#include "GigaTokenizer.hpp"
+
+// Parser used by getMainContent/getMultipleContents. Native skips HTML5 tree
+// construction and runs the extractors on GigaTokenizer output; it is faster
+// but nests misnested markup differently from Gumbo.
+enum class HtmlParser
+{
+    Gumbo,
+    Native
+};
+
+// What htmlToText does with character references.
+enum class EntityMode
+{
+    Decode, // as encodeHtmlEntities
+    Remove, // as removeHtmlEntities
+    Keep
+};
+
+// Stages of htmlToText. Markup, comments, CDATA and doctypes always go. The
+// defaults give the output of the chained calls htmlToText replaces on pages
+// whose script and style elements are closed; the README lists the rest.
+struct HtmlToTextOptions
+{
+    bool dropRawText = true; // <script> and <style> bodies, lowercase tags only as in removeScriptAndStyleTags
+    bool dropSvg = true;
+    EntityMode entities = EntityMode::Decode;
+    bool blockNewlines = false;      // line break at block element boundaries
+    bool normalizeWhitespace = true; // as cleanTXT
+};
+
 class GigaWeb
 {
 private:
-    static size_t WriteCallback(void *contents, size_t size, size_t nmemb, void *userp)
+    HtmlParser htmlParser = HtmlParser::Gumbo;
+
+    // Blanks collapsed by cleanTXT, and the \s class it trims.
+    static bool isBlank(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\n';
+    }
+
+    static bool isTrimSpace(char c)
     {
-        ((std::string *)userp)->append((char *)contents, size * nmemb);
-        return size * nmemb;
+        return c == ' ' || (c >= '\t' && c <= '\r');
     }
 
-    void extract_main_content(GumboNode *node, size_t &max_words, std::string &content)
+    // Output of htmlToText. With normalize, text goes through the cleanTXT
+    // rules as it is appended: leading \s is skipped, a run of blanks is
+    // held back until the next character shows it is not trailing, and
+    // finish() trims what is left.
+    struct TextSink
     {
-        if (node->type == GUMBO_NODE_TEXT)
+        std::string &out;
+        size_t start;
+        bool normalize;
+        char pending = 0;
+
+        TextSink(std::string &out, bool normalize) : out(out), start(out.size()), normalize(normalize)
         {
-            std::string text(node->v.text.text);
-            size_t word_count = std::count(text.begin(), text.end(), ' ') + 1;
+        }
 
-            if (word_count > max_words)
+        void put(const char *p, const char *end)
+        {
+            if (!normalize)
             {
-                max_words = word_count;
-                content = text;
+                out.append(p, end);
+                return;
             }
+            while (p < end)
+            {
+                if (out.size() == start)
+                {
+                    while (p < end && isTrimSpace(*p))
+                        ++p;
+                    if (p == end)
+                        return;
+                }
+
+                const char *blank = GigaScan::findAny(p, end, ' ', '\t', '\n');
+                if (blank > p)
+                {
+                    if (pending && out.size() > start)
+                        out.push_back(pending);
+                    pending = 0;
+                    out.append(p, blank);
+                    p = blank;
+                }
+                for (; p < end && isBlank(*p); ++p)
+                    pending = *p == '\n' || pending == '\n' ? '\n' : ' ';
+            }
+        }
+
+        void put(std::string_view text)
+        {
+            put(text.data(), text.data() + text.size());
         }
-        else if (node->type == GUMBO_NODE_ELEMENT && node->v.element.tag != GUMBO_TAG_SCRIPT &&
-                 node->v.element.tag != GUMBO_TAG_STYLE)
+
+        void lineBreak()
         {
-            GumboVector *children = &node->v.element.children;
+            if (normalize)
+                pending = '\n';
+            else if (out.size() > start && out.back() != '\n')
+                out.push_back('\n');
+        }
+
+        void finish()
+        {
+            if (!normalize)
+                return;
+            pending = 0;
+            while (out.size() > start && isTrimSpace(out.back()))
+                out.pop_back();
+        }
+    };
+
+    // Same count as std::count(text, ' ') + 1, without leaving the view.
+    static size_t countWords(std::string_view text)
+    {
+        return GigaScan::count(text.data(), text.data() + text.size(), ' ') + 1;
+    }
+
+    // Both extractors scan the flat DOM linearly. Non-element nodes carry
+    // GUMBO_TAG_UNKNOWN, which no TagSet contains, so one bit test per node
+    // decides whether to jump over its subtree.
+    // The winning text is only copied once, after the scan.
+    static void extract_main_content(const FlatDom &dom, const ExtractionPolicy &policy, size_t &max_words, std::string &content)
+    {
+        uint32_t best = DomNode::kNone;
+        for (uint32_t i = 0; i < dom.size();)
+        {
+            const DomNode &node = dom[i];
+            if (policy.skipTags.contains(node.tag))
+            {
+                i = node.subtreeEnd;
+                continue;
+            }
+            if (node.type == GUMBO_NODE_TEXT)
+            {
+                std::string_view text = dom.text(i);
+                size_t word_count = countWords(text);
+
+                if (word_count > max_words && policy.accepts(word_count, text.size()))
+                {
+                    max_words = word_count;
+                    best = i;
+                }
+            }
+            ++i;
+        }
+        if (best != DomNode::kNone)
+            content = dom.text(best);
+    }
+
+    // Text of the block GigaReadability scores best; pages with no paragraph
+    // long enough to score fall back to their longest text node.
+    static std::string main_content(const FlatDom &dom)
+    {
+        ContentCandidate best = GigaReadability::best(dom);
+        if (best.node != DomNode::kNone)
+            return GigaReadability::textOf(dom, best.node);
+
+        size_t max_words = 0;
+        std::string content;
+        extract_main_content(dom, ExtractionPolicy::mainContent(), max_words, content);
+        return content;
+    }
 
-            for (unsigned int i = 0; i < children->length; ++i)
+    static void extract_multiple_contents(const FlatDom &dom, const ExtractionPolicy &policy, std::vector<std::string> &contents)
+    {
+        std::unordered_set<std::string_view> seen;
+        for (uint32_t i = 0; i < dom.size();)
+        {
+            const DomNode &node = dom[i];
+            if (policy.skipTags.contains(node.tag))
             {
-                extract_main_content(static_cast<GumboNode *>(children->data[i]), max_words, content);
+                i = node.subtreeEnd;
+                continue;
             }
+            if (node.type == GUMBO_NODE_TEXT)
+            {
+                std::string_view text = dom.text(i);
+                size_t word_count = countWords(text);
+
+                if (policy.accepts(word_count, text.size()) && (!policy.dedup || seen.insert(text).second))
+                {
+                    contents.emplace_back(text);
+                }
+            }
+            ++i;
         }
     }
 
-    void extract_multiple_contents(GumboNode *node, std::vector<std::string> &contents)
+    static bool resolveURL(std::string &url, const std::string &baseURL)
     {
-        if (node->type == GUMBO_NODE_TEXT)
+        if (url.empty() || !isalpha(static_cast<unsigned char>(url[0])))
+            return false;
+
+        if (url[0] == '/')
+            url = baseURL + url;
+        else if (url.find("://") == std::string::npos)
+            url = "http://" + url;
+        return true;
+    }
+
+public:
+    // A parsed page. The HTML is parsed once and every query below walks the
+    // same Gumbo tree, so several extractions per page cost one parse. The
+    // content extractors run on a flat copy of the tree (see GigaDom.hpp),
+    // built on first use. The Gumbo tree lives in blocks of the creating
+    // thread's GigaArena that are returned when the Document is destroyed,
+    // so destroy a Document on the thread that made it.
+    // Pages of FlatDom::kMaxSource bytes or more are not parsed: root() is
+    // null and the extractors return nothing.
+    class Document
+    {
+    public:
+        explicit Document(const std::string &html, const std::string &baseURL = "")
+            : html(std::make_unique<std::string>(html)), baseURL(baseURL), parse(std::make_unique<GigaArena::Parse>(GigaArena::local()))
+        {
+            GumboOptions options = parse->options();
+            if (FlatDom::fits(*this->html))
+                output = gumbo_parse_with_options(&options, this->html->data(), this->html->size());
+        }
+
+        Document(Document &&other) noexcept
+            : html(std::move(other.html)), baseURL(std::move(other.baseURL)), parse(std::move(other.parse)),
+              output(std::exchange(other.output, nullptr)), flatDom(std::move(other.flatDom))
+        {
+        }
+
+        Document(const Document &) = delete;
+        Document &operator=(const Document &) = delete;
+        Document &operator=(Document &&) = delete;
+
+        const std::string &source() const
+        {
+            return *html;
+        }
+
+        GumboNode *root() const
+        {
+            return output ? output->root : nullptr;
+        }
+
+        const FlatDom &dom() const
+        {
+            if (!flatDom)
+                flatDom = std::make_unique<FlatDom>(FlatDom::fromGumbo(output, *html));
+            return *flatDom;
+        }
+
+        std::string mainContent() const
+        {
+            return main_content(dom());
+        }
+
+        // The block mainContent() comes from, as an index into dom().
+        ContentCandidate mainCandidate() const
+        {
+            return GigaReadability::best(dom());
+        }
+
+        std::vector<std::string> multipleContents(const ExtractionPolicy &policy = ExtractionPolicy::multipleContents()) const
+        {
+            std::vector<std::string> contents;
+            extract_multiple_contents(dom(), policy, contents);
+            return contents;
+        }
+
+        // Indices into dom() of the elements matching a CSS selector.
+        std::vector<uint32_t> select(const GigaSelector &selector) const
+        {
+            return selector.select(dom());
+        }
+
+        std::vector<uint32_t> select(const std::string &selector) const
         {
-            std::string text(node->v.text.text);
-            size_t word_count = std::count(text.begin(), text.end(), ' ') + 1;
+            return select(GigaSelector(selector));
+        }
+
+        std::vector<std::string> selectText(const std::string &selector) const
+        {
+            std::vector<std::string> texts;
+            for (uint32_t node : select(selector))
+                texts.push_back(dom().textContent(node));
+            return texts;
+        }
 
-            if (word_count > 20)
+        // Same filtering and resolution rules as GigaWeb::extractURLs.
+        std::vector<std::string> links() const
+        {
+            std::vector<std::string> urls;
+            std::unordered_set<std::string> uniqueUrls;
+            forEachElement([&](GumboNode *node)
+                           {
+                if (node->v.element.tag != GUMBO_TAG_A)
+                    return;
+                GumboAttribute *href = gumbo_get_attribute(&node->v.element.attributes, "href");
+                if (!href)
+                    return;
+                std::string url = href->value;
+                if (resolveURL(url, baseURL) && uniqueUrls.insert(url).second)
+                    urls.push_back(url); });
+            return urls;
+        }
+
+        std::vector<std::string> images() const
+        {
+            return attributeValues("img", "src");
+        }
+
+        std::vector<std::string> attributeValues(const std::string &tag, const std::string &attribute) const
+        {
+            std::vector<std::string> values;
+            for (GumboNode *node : elements(tag))
             {
-                contents.push_back(text);
+                GumboAttribute *attr = gumbo_get_attribute(&node->v.element.attributes, attribute.c_str());
+                if (attr)
+                    values.push_back(attr->value);
+            }
+            return values;
+        }
+
+        std::string attributeValue(const std::string &tag, const std::string &attribute) const
+        {
+            std::vector<std::string> values = attributeValues(tag, attribute);
+            return values.empty() ? "" : values.front();
+        }
+
+        std::vector<GumboNode *> elements(const std::string &tag) const
+        {
+            std::vector<GumboNode *> found;
+            GumboTag tagId = gumbo_tag_enum(tag.c_str());
+            forEachElement([&](GumboNode *node)
+                           {
+                if (isTag(node, tagId, tag))
+                    found.push_back(node); });
+            return found;
+        }
+
+        bool hasTag(const std::string &tag) const
+        {
+            return !elements(tag).empty();
+        }
+
+        size_t countTag(const std::string &tag) const
+        {
+            return elements(tag).size();
+        }
+
+        // Text of every element with the given tag name, in document order.
+        std::vector<std::string> textContents(const std::string &tag) const
+        {
+            std::vector<std::string> texts;
+            for (GumboNode *node : elements(tag))
+                texts.push_back(textOf(node));
+            return texts;
+        }
+
+        static std::string textOf(GumboNode *node)
+        {
+            std::string text;
+            std::vector<GumboNode *> &stack = walkStack();
+            stack.assign(1, node);
+            while (!stack.empty())
+            {
+                GumboNode *current = stack.back();
+                stack.pop_back();
+                if (current->type == GUMBO_NODE_TEXT || current->type == GUMBO_NODE_WHITESPACE || current->type == GUMBO_NODE_CDATA)
+                {
+                    text += current->v.text.text;
+                }
+                else if (current->type == GUMBO_NODE_ELEMENT)
+                {
+                    GumboVector *children = &current->v.element.children;
+                    for (unsigned int i = children->length; i > 0; --i)
+                        stack.push_back(static_cast<GumboNode *>(children->data[i - 1]));
+                }
             }
+            return text;
+        }
+
+    private:
+        // Heap-allocated so the tree's pointers into it survive a move.
+        std::unique_ptr<std::string> html;
+        std::string baseURL;
+        std::unique_ptr<GigaArena::Parse> parse;
+        GumboOutput *output = nullptr;
+        mutable std::unique_ptr<FlatDom> flatDom;
+
+        // Explicit stack shared by the tree walkers of this thread, so deep
+        // pages cannot overflow the call stack and walks allocate nothing once
+        // it has grown. The walkers never nest.
+        static std::vector<GumboNode *> &walkStack()
+        {
+            static thread_local std::vector<GumboNode *> stack;
+            return stack;
+        }
+
+        static bool isTag(GumboNode *node, GumboTag tagId, const std::string &name)
+        {
+            if (node->v.element.tag != tagId)
+                return false;
+            if (tagId != GUMBO_TAG_UNKNOWN)
+                return true;
+
+            GumboStringPiece original = node->v.element.original_tag;
+            gumbo_tag_from_original_text(&original);
+            return original.length == name.size() && strncasecmp(original.data, name.data(), name.size()) == 0;
         }
-        else if (node->type == GUMBO_NODE_ELEMENT &&
-                 node->v.element.tag != GUMBO_TAG_SCRIPT &&
-                 node->v.element.tag != GUMBO_TAG_STYLE &&
-                 node->v.element.tag != GUMBO_TAG_HEADER &&
-                 node->v.element.tag != GUMBO_TAG_FOOTER &&
-                 node->v.element.tag != GUMBO_TAG_NAV &&
-                 node->v.element.tag != GUMBO_TAG_ASIDE)
+
+        template <typename Visitor>
+        void forEachElement(Visitor visit) const
         {
-            GumboVector *children = &node->v.element.children;
+            if (!root())
+                return;
 
-            for (unsigned int i = 0; i < children->length; ++i)
+            std::vector<GumboNode *> &stack = walkStack();
+            stack.assign(1, root());
+            while (!stack.empty())
             {
-                extract_multiple_contents(static_cast<GumboNode *>(children->data[i]), contents);
+                GumboNode *node = stack.back();
+                stack.pop_back();
+                if (node->type != GUMBO_NODE_ELEMENT)
+                    continue;
+
+                visit(node);
+                GumboVector *children = &node->v.element.children;
+                for (unsigned int i = children->length; i > 0; --i)
+                    stack.push_back(static_cast<GumboNode *>(children->data[i - 1]));
             }
         }
+    };
+
+    Document parse(const std::string &html, const std::string &baseURL = "")
+    {
+        return Document(html, baseURL);
     }
 
-public:
+    void setHtmlParser(HtmlParser parser)
+    {
+        htmlParser = parser;
+    }
+
+    HtmlParser getHtmlParser() const
+    {
+        return htmlParser;
+    }
+
+    // Applies a compiled ExtractionPlan to one page, parsed with the
+    // parser chosen by setHtmlParser.
+    ExtractedRecord extract(const ExtractionPlan &plan, const std::string &html)
+    {
+        if (htmlParser == HtmlParser::Native)
+            return plan.apply(std::string_view(html));
+        return plan.apply(Document(html).dom());
+    }
+
+    GigaFetcher fetcher;
+    GigaScheduler scheduler{[this](const std::string &url)
+                            { return extractDomainFromURL(url); }};
+    GigaMetrics metrics{[this](const std::string &url)
+                        { return extractDomainFromURL(url); }};
+
     bool isValidURL(const std::string &url)
     {
-        std::regex urlPattern(R"(^(https?|ftp)://[^\s/$.?#].[^\s]*$)");
-        return std::regex_match(url, urlPattern);
+        return GigaFetcher::isValidURL(url);
     }
 
     bool fetchWebContent(const std::string &url, std::string &content)
@@ -92,77 +505,237 @@ public:
             return false;
         }
         printf("\n%s\n",url.c_str());
-        CURL *curl;
-        CURLcode res;
-        long httpCode = 0;
-        char *contentType = nullptr;
 
-        curl_global_init(CURL_GLOBAL_DEFAULT);
-        curl = curl_easy_init();
-        if (curl)
+        FetchResult result = fetchWebResult(url);
+        if (result.rejection != FetchRejection::None)
+            return false;
+        if (result.curlCode != CURLE_OK)
         {
-            struct curl_slist *headers = nullptr;
-            headers = curl_slist_append(headers, "User-Agent: Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/58.0.3029.110 Safari/537");
+            std::cerr << "curl_easy_perform() failed: " << curl_easy_strerror(result.curlCode) << std::endl;
+            return false;
+        }
 
-            curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-            curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-            curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-            curl_easy_setopt(curl, CURLOPT_WRITEDATA, &content);
-            curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+        content.append(result.content);
+        return result.success;
+    }
 
-            res = curl_easy_perform(curl);
+    FetchResult fetchWebResult(const std::string &url)
+    {
+        FetchResult result = fetcher.fetch(url);
+        metrics.record(result);
+        return result;
+    }
 
-            if (res != CURLE_OK)
-            {
-                std::cerr << "curl_easy_perform() failed: " << curl_easy_strerror(res) << std::endl;
-                return false;
-            }
+    // Feeds the body to parser while it downloads; result.content stays empty.
+    FetchResult streamWebContent(const std::string &url, GigaStreamParser &parser)
+    {
+        FetchResult result = fetcher.fetch(url, parser.bodyCallback());
+        parser.finish();
+        metrics.record(result);
+        return result;
+    }
+
+    void fetchWebContents(const std::vector<std::string> &urls, const GigaFetcher::CompletionCallback &onComplete)
+    {
+        fetcher.submit(urls);
+        fetcher.run([this, &onComplete](FetchResult &result)
+                    {
+                        metrics.record(result);
+                        onComplete(result); });
+    }
 
-            curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &httpCode);
-            curl_easy_getinfo(curl, CURLINFO_CONTENT_TYPE, &contentType);
+    // Fetches everything queued in scheduler (and anything pushed from onComplete),
+    // releasing URLs to the fetcher only as per-host tokens and slots allow.
+    void crawl(const GigaFetcher::CompletionCallback &onComplete)
+    {
+        auto finished = [this, &onComplete](FetchResult &result)
+        {
+            scheduler.complete(result.url, result.httpCode, result.timings.total);
+            metrics.record(result);
+            onComplete(result);
+        };
 
-            curl_slist_free_all(headers);
+        while (!scheduler.empty() || fetcher.pending())
+        {
+            std::string url;
+            while (fetcher.pending() < fetcher.getMaxInFlight() && scheduler.pop(url))
+                fetcher.submit(url);
 
-            if (httpCode == 200 && contentType &&
-                (std::string(contentType).find("text/html") != std::string::npos ||
-                 std::string(contentType).find("application/json") != std::string::npos))
-            {
-                curl_easy_cleanup(curl);
-                curl_global_cleanup();
-                return true;
-            }
-            else
-            {
-                // std::cerr << "Invalid HTTP status code or content type.\n";
-                // std::cerr << "HTTP Status Code: " << httpCode << "\n";
-                // std::cerr << "Content Type: " << (contentType ? contentType : "Unknown") << "\n";
-                return false;
-            }
+            auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(scheduler.nextReadyIn());
+            fetcher.runOnce(finished, static_cast<int>(std::max<std::chrono::milliseconds::rep>(wait.count(), 1)));
         }
-
-        curl_global_cleanup();
-        return false;
     }
 
+    // Same result as the former four regex passes ("[ \t]+" -> " ",
+    // "[ \t]*\n[ \t]*" -> "\n", trim "\s", "\n+" -> "\n") in one pass:
+    // inside the trimmed range every run of spaces, tabs and newlines becomes
+    // "\n" if it holds a newline and " " otherwise.
     std::string cleanTXT(const std::string &input)
     {
-        static const std::regex spacePattern("[ \t]+");
-        static const std::regex newlinePattern("[ \t]*\n[ \t]*");
-        static const std::regex trimPattern("^\\s+|\\s+$");
-        static const std::regex multiNewlinePattern("\n+");
+        std::string output(input.size(), '\0');
+        output.resize(cleanTXT(input.data(), input.size(), &output[0]));
+        return output;
+    }
 
-        std::string output = std::regex_replace(input, spacePattern, " ");
-        output = std::regex_replace(output, newlinePattern, "\n");
-        output = std::regex_replace(output, trimPattern, "");
-        output = std::regex_replace(output, multiNewlinePattern, "\n");
+    // Writes at most length bytes to output and returns how many; output may
+    // be input itself.
+    size_t cleanTXT(const char *input, size_t length, char *output)
+    {
+        const char *p = input;
+        const char *end = input + length;
+        while (p < end && isTrimSpace(*p))
+            ++p;
+        while (end > p && isTrimSpace(end[-1]))
+            --end;
+
+        // 64 bytes at a time: copy up to the first tab, newline or space
+        // followed by another blank, then collapse that run.
+        char *out = output;
+        while (p < end)
+        {
+            size_t window = std::min<size_t>(64, static_cast<size_t>(end - p));
+            uint64_t blank = GigaScan::matchMask64(p, end, ' ', '\t', '\n', '\n');
+            uint64_t run = GigaScan::matchMask64(p, end, '\t', '\n', '\t', '\n') | (blank & (blank >> 1));
+            if (window == 64 && (blank >> 63) && p + 64 < end && isBlank(p[64]))
+                run |= uint64_t(1) << 63;
+
+            size_t plain = run ? GigaScan::firstBit(run) : window;
+            std::memmove(out, p, plain);
+            out += plain;
+            p += plain;
+            if (!run)
+                continue;
 
+            bool newline = false;
+            for (; isBlank(*p); ++p)
+                newline |= *p == '\n';
+            *out++ = newline ? '\n' : ' ';
+        }
+        return static_cast<size_t>(out - output);
+    }
+
+    void cleanTXTInPlace(std::string &text)
+    {
+        text.resize(cleanTXT(text.data(), text.size(), &text[0]));
+    }
+
+    // Text of an HTML document without its markup. One GigaTokenizer pass
+    // drops tags, comments, CDATA and doctypes; '>' inside quoted attribute
+    // values stays inside the tag. The bodies of script/style like elements
+    // are kept verbatim, as the old regex did (htmlToText drops them).
+    // Character references are kept as written. With blockNewlines every
+    // block element boundary becomes a line break.
+    std::string cleanHTML(const std::string &html, bool blockNewlines = false)
+    {
+        std::string output(html.size(), '\0');
+        output.resize(cleanHTML(html.data(), html.size(), &output[0], blockNewlines));
         return output;
     }
 
-    std::string cleanHTML(std::string &html)
+    // Writes at most length bytes to output and returns how many; output may
+    // be html itself, the write position never passes the read position.
+    size_t cleanHTML(const char *html, size_t length, char *output, bool blockNewlines = false)
     {
-        static const std::regex tagRegex("<[^>]+>");
-        return std::regex_replace(html, tagRegex, "");
+        GigaTokenizer tokenizer(std::string_view(html, length));
+        HtmlToken token;
+        char *out = output;
+        while (tokenizer.next(token))
+        {
+            if (token.type == HtmlTokenType::Text)
+            {
+                std::memmove(out, token.text.data(), token.text.size());
+                out += token.text.size();
+            }
+            else if (blockNewlines && (token.type == HtmlTokenType::StartTag || token.type == HtmlTokenType::EndTag) &&
+                     GigaReadability::isBlock(token.tag) && out != output && out[-1] != '\n')
+            {
+                *out++ = '\n';
+            }
+        }
+        return static_cast<size_t>(out - output);
+    }
+
+    // Page to clean text in one GigaTokenizer pass, doing what chaining
+    // removeScriptAndStyleTags, removePathAndSvgTags, removeAllCommentsFromHTML,
+    // cleanHTML, encodeHtmlEntities and cleanTXT does, without an intermediate
+    // copy per step.
+    std::string htmlToText(const std::string &html, const HtmlToTextOptions &options = HtmlToTextOptions())
+    {
+        std::string text;
+        text.reserve(html.size());
+        htmlToText(html, text, options);
+        return text;
+    }
+
+    // Appends to out, so a buffer reused across pages stops allocating once
+    // it is large enough.
+    void htmlToText(std::string_view html, std::string &out, const HtmlToTextOptions &options = HtmlToTextOptions())
+    {
+        TextSink sink(out, options.normalizeWhitespace);
+        GigaTokenizer tokenizer(html);
+        HtmlToken token;
+        std::string decoded;
+        size_t svgDepth = 0;
+        bool dropBody = false; // the raw text that follows belongs to a dropped element
+        while (tokenizer.next(token))
+        {
+            switch (token.type)
+            {
+            case HtmlTokenType::Text:
+                if (svgDepth || (token.rawText && dropBody))
+                    break;
+                if (options.entities == EntityMode::Keep)
+                {
+                    sink.put(token.text);
+                    break;
+                }
+                for (const char *p = token.text.data(), *end = p + token.text.size(); p < end;)
+                {
+                    const char *amp = GigaScan::find(p, end, '&');
+                    sink.put(p, amp);
+                    if (amp == end)
+                        break;
+
+                    std::string_view named;
+                    uint32_t code;
+                    std::string_view rest(amp + 1, static_cast<size_t>(end - amp - 1));
+                    size_t length = options.entities == EntityMode::Remove ? GigaEntities::matchTerminated(rest) : GigaEntities::match(rest, named, code);
+                    if (!length)
+                    {
+                        sink.put(amp, amp + 1);
+                    }
+                    else if (options.entities == EntityMode::Decode)
+                    {
+                        decoded.clear();
+                        if (named.empty())
+                            GigaEntities::appendUtf8(code, decoded);
+                        sink.put(named.empty() ? std::string_view(decoded) : named);
+                    }
+                    p = amp + 1 + length;
+                }
+                break;
+
+            case HtmlTokenType::StartTag:
+            case HtmlTokenType::EndTag:
+                dropBody = options.dropRawText && token.type == HtmlTokenType::StartTag && (token.name == "script" || token.name == "style");
+                if (options.dropSvg && token.tag == GUMBO_TAG_SVG && !token.selfClosing)
+                {
+                    if (token.type == HtmlTokenType::StartTag)
+                        ++svgDepth;
+                    else if (svgDepth)
+                        --svgDepth;
+                }
+                else if (options.blockNewlines && !svgDepth && GigaReadability::isBlock(token.tag))
+                {
+                    sink.lineBreak();
+                }
+                break;
+
+            default:
+                break;
+            }
+        }
+        sink.finish();
     }
 
     std::string removeScriptAndStyleTags(const std::string &html)
@@ -286,56 +859,36 @@ public:
         return result;
     }
 
+    // Replaces character references with the characters they stand for
+    // (named, including the legacy forms without ';', and numeric).
     std::string encodeHtmlEntities(const std::string &html)
     {
         std::string cleanedHtml;
         cleanedHtml.reserve(html.size());
-
-        std::regex htmlEntitiesPattern(R"(&\w+;)");
-        std::sregex_iterator htmlEntitiesIterator(html.begin(), html.end(), htmlEntitiesPattern);
-        std::sregex_iterator htmlEntitiesEnd;
-
-        std::string::const_iterator searchStart = html.begin();
-
-        for (std::sregex_iterator i = htmlEntitiesIterator; i != htmlEntitiesEnd; ++i)
-        {
-            std::smatch match = *i;
-            auto it = knownEntities.find(match.str());
-            if (it != knownEntities.end())
-            {
-                cleanedHtml.append(searchStart, html.begin() + match.position());
-                cleanedHtml.append(it->second);
-                searchStart = html.begin() + match.position() + match.length();
-            }
-        }
-
-        cleanedHtml.append(searchStart, html.end());
-
+        GigaEntities::decode(html, cleanedHtml);
         return cleanedHtml;
     }
+    // Drops the known "&name;" references; numeric references and legacy
+    // names without ';' are kept.
     std::string removeHtmlEntities(const std::string &html)
     {
         std::string cleanedHtml;
         cleanedHtml.reserve(html.size());
 
-        std::regex htmlEntitiesPattern(R"(&\w+;)");
-        std::sregex_iterator htmlEntitiesIterator(html.begin(), html.end(), htmlEntitiesPattern);
-        std::sregex_iterator htmlEntitiesEnd;
-
-        std::string::const_iterator searchStart = html.begin();
-
-        for (std::sregex_iterator i = htmlEntitiesIterator; i != htmlEntitiesEnd; ++i)
+        const char *p = html.data();
+        const char *end = p + html.size();
+        while (p < end)
         {
-            std::smatch match = *i;
-            auto it = knownEntities.find(match.str());
-            if (it != knownEntities.end())
-            {
-                cleanedHtml.append(searchStart, html.begin() + match.position());
-                searchStart = html.begin() + match.position() + match.length();
-            }
-        }
+            const char *amp = GigaScan::find(p, end, '&');
+            cleanedHtml.append(p, amp);
+            if (amp == end)
+                break;
 
-        cleanedHtml.append(searchStart, html.end());
+            size_t length = GigaEntities::matchTerminated(std::string_view(amp + 1, static_cast<size_t>(end - amp - 1)));
+            if (!length)
+                cleanedHtml.push_back('&');
+            p = amp + 1 + length;
+        }
 
         return cleanedHtml;
     }
@@ -348,6 +901,13 @@ public:
         return (html.find(openingTag) != std::string::npos) || (html.find(closingTag) != std::string::npos);
     }
 
+    // The HtmlIndex overloads below return the same results as the
+    // std::string versions; build the index once to run many queries on a page.
+    bool hasTag(const HtmlIndex &index, const std::string &tag)
+    {
+        return index.find("<" + tag) != std::string::npos || index.find("</" + tag + ">") != std::string::npos;
+    }
+
     std::string getAttributeValue(const std::string &html, const std::string &tag, const std::string &attribute)
     {
         std::string openingTag = "<" + tag;
@@ -372,6 +932,28 @@ public:
         return html.substr(valueStartPos + 1, valueEndPos - valueStartPos - 1);
     }
 
+    std::string getAttributeValue(const HtmlIndex &index, const std::string &tag, const std::string &attribute)
+    {
+        std::string_view html = index.source();
+        size_t openingTagPos = index.find("<" + tag);
+        if (openingTagPos == std::string::npos)
+            return "";
+
+        size_t attributePos = index.find(attribute, openingTagPos);
+        if (attributePos == std::string::npos)
+            return "";
+
+        size_t valueStartPos = index.findQuote(attributePos);
+        if (valueStartPos == std::string::npos)
+            return "";
+
+        size_t valueEndPos = index.findQuote(valueStartPos + 1);
+        if (valueEndPos == std::string::npos)
+            return "";
+
+        return std::string(html.substr(valueStartPos + 1, valueEndPos - valueStartPos - 1));
+    }
+
     std::string replaceTag(const std::string &html, const std::string &oldTag, const std::string &newTag)
     {
         std::string replacedHtml = html;
@@ -412,6 +994,21 @@ public:
         return html.substr(startPos, endPos - startPos);
     }
 
+    std::string extractContentBetweenTags(const HtmlIndex &index, const std::string &startTag, const std::string &endTag)
+    {
+        size_t startPos = index.find(startTag);
+        if (startPos == std::string::npos)
+            return "";
+
+        startPos += startTag.length();
+
+        size_t endPos = index.find(endTag, startPos);
+        if (endPos == std::string::npos)
+            return "";
+
+        return std::string(index.source().substr(startPos, endPos - startPos));
+    }
+
     int countTagOccurrences(const std::string &html, const std::string &tag)
     {
         int count = 0;
@@ -435,6 +1032,11 @@ public:
         return count;
     }
 
+    int countTagOccurrences(const HtmlIndex &index, const std::string &tag)
+    {
+        return static_cast<int>(index.count("<" + tag) + index.count("</" + tag + ">"));
+    }
+
     bool hasAttribute(const std::string &html, const std::string &tag, const std::string &attribute)
     {
         std::string openingTag = "<" + tag;
@@ -516,6 +1118,33 @@ public:
         return attributeValues;
     }
 
+    std::vector<std::string> getAttributeValues(const HtmlIndex &index, const std::string &tag, const std::string &attribute)
+    {
+        std::vector<std::string> attributeValues;
+        std::string_view html = index.source();
+        std::string openingTag = "<" + tag;
+
+        size_t pos = index.find(openingTag);
+        while (pos != std::string::npos)
+        {
+            size_t attributePos = index.find(attribute, pos);
+            if (attributePos != std::string::npos)
+            {
+                size_t valueStartPos = index.findQuote(attributePos);
+                if (valueStartPos != std::string::npos)
+                {
+                    size_t valueEndPos = index.findQuote(valueStartPos + 1);
+                    if (valueEndPos != std::string::npos)
+                        attributeValues.emplace_back(html.substr(valueStartPos + 1, valueEndPos - valueStartPos - 1));
+                }
+            }
+
+            pos = index.find(openingTag, pos + openingTag.length());
+        }
+
+        return attributeValues;
+    }
+
     void addTag(std::string &html, const std::string &tag, const std::string &content)
     {
         std::string newTag = "<" + tag + ">" + content + "</" + tag + ">";
@@ -617,12 +1246,7 @@ std::vector<std::string> extractURLs(const std::string &html, const std::string
 
         std::string url = html.substr(startQuote, endQuote - startQuote);
 
-        if (!url.empty() && isalpha(url[0])) {
-            if (url[0] == '/')
-                url = baseURL + url;
-            else if (url.find("://") == std::string::npos)
-                url = "http://" + url;
-
+        if (resolveURL(url, baseURL)) {
             if (uniqueUrls.find(url) == uniqueUrls.end()) {
                 uniqueUrls.insert(url);
                 urls.push_back(url);
@@ -634,6 +1258,45 @@ std::vector<std::string> extractURLs(const std::string &html, const std::string
     return urls;
 }
 
+std::vector<std::string> extractURLs(const HtmlIndex &index, const std::string &baseURL = "") {
+    std::vector<std::string> urls;
+    std::unordered_set<std::string> uniqueUrls;
+    std::string_view html = index.source();
+
+    std::string::size_type pos = 0;
+    std::string::size_type end = 0;
+
+    while ((pos = index.find("<a ", pos)) != std::string::npos) {
+        end = index.find(">", pos);
+        if (end == std::string::npos) break;
+
+        // Matches past the tag's '>' are rejected anyway, so search only inside it.
+        std::string_view tag = html.substr(pos, end - pos);
+        std::string::size_type startQuote = tag.find("href=\"");
+        if (startQuote == std::string::npos) {
+            pos = end + 1;
+            continue;
+        }
+        startQuote += 6;  // Length of "href=\""
+
+        std::string::size_type endQuote = tag.find('\"', startQuote);
+        if (endQuote == std::string::npos) {
+            pos = end + 1;
+            continue;
+        }
+
+        std::string url(tag.substr(startQuote, endQuote - startQuote));
+
+        if (resolveURL(url, baseURL)) {
+            if (uniqueUrls.insert(url).second)
+                urls.push_back(url);
+        }
+        pos = end + 1;
+    }
+
+    return urls;
+}
+
 
     std::string extractScriptSection(const std::string &html)
     {
@@ -1119,38 +1782,19 @@ std::vector<std::string> extractURLs(const std::string &html, const std::string
 
     std::string getMainContent(const std::string &html)
     {
-        GumboOutput *output = gumbo_parse(html.c_str());
-
-        size_t max_words = 0;
-        std::string content;
-        extract_main_content(output->root, max_words, content);
-
-        gumbo_destroy_output(&kGumboDefaultOptions, output);
-
-        return content;
+        if (htmlParser == HtmlParser::Native)
+            return main_content(GigaTokenizer::toFlatDom(html));
+        return Document(html).mainContent();
     }
-    std::vector<std::string> getMultipleContents(const std::string &html)
+    std::vector<std::string> getMultipleContents(const std::string &html, const ExtractionPolicy &policy = ExtractionPolicy::multipleContents())
     {
-        GumboOutput *output = gumbo_parse(html.c_str());
-
-        std::vector<std::string> contents;
-        std::unordered_set<std::string> unique_contents;
-
-        extract_multiple_contents(output->root, contents);
-
-        gumbo_destroy_output(&kGumboDefaultOptions, output);
-
-        std::vector<std::string> unique_vector;
-        for (const auto &str : contents)
+        if (htmlParser == HtmlParser::Native)
         {
-            if (unique_contents.find(str) == unique_contents.end())
-            {
-                unique_vector.push_back(str);
-                unique_contents.insert(str);
-            }
+            std::vector<std::string> contents;
+            extract_multiple_contents(GigaTokenizer::toFlatDom(html), policy, contents);
+            return contents;
         }
-
-        return unique_vector;
+        return Document(html).multipleContents(policy);
     }
     std::string extractDomainFromURL(const std::string &url)
     {
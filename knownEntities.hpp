@@ -1,5 +1,17 @@
+#pragma once
+#include <string_view>
 
-  const std::unordered_map<std::string, std::string> knownEntities = {
+// HTML5 named character references, sorted by name (byte order) so they can
+// be binary searched straight from read-only data: no construction at
+// startup and one definition shared by every translation unit. Names keep
+// the leading '&'; the legacy ones that may omit ';' appear in both forms.
+struct KnownEntity
+{
+    std::string_view name;
+    std::string_view value;
+};
+
+  inline constexpr KnownEntity knownEntities[] = {
 {"&AElig","Æ"},
 {"&AElig;","Æ"},
 {"&AMP","&"},
@@ -325,6 +337,7 @@
 {"&NegativeVeryThinSpace;","​"},
 {"&NestedGreaterGreater;","≫"},
 {"&NestedLessLess;","≪"},
+{"&NewLine;","\n"},
 {"&Nfr;","𝔑"},
 {"&NoBreak;","⁠"},
 {"&NonBreakingSpace;"," "},
@@ -391,7 +404,6 @@
 {"&Ocirc","Ô"},
 {"&Ocirc;","Ô"},
 {"&Ocy;","О"},
-
 {"&Odblac;","Ő"},
 {"&Ofr;","𝔒"},
 {"&Ograve","Ò"},
@@ -623,6 +635,29 @@
 {"&Yfr;","𝔜"},
 {"&Yopf;","𝕐"},
 {"&Yscr;","𝒴"},
+{"&Yuml;","Ÿ"},
+{"&ZHcy;","Ж"},
+{"&Zacute;","Ź"},
+{"&Zcaron;","Ž"},
+{"&Zcy;","З"},
+{"&Zdot;","Ż"},
+{"&ZeroWidthSpace;","​"},
+{"&Zeta;","Ζ"},
+{"&Zfr;","ℨ"},
+{"&Zopf;","ℤ"},
+{"&Zscr;","𝒵"},
+{"&aacute","á"},
+{"&aacute;","á"},
+{"&abreve;","ă"},
+{"&ac;","∾"},
+{"&acE;","∾̳"},
+{"&acd;","∿"},
+{"&acirc","â"},
+{"&acirc;","â"},
+{"&acute","´"},
+{"&acute;","´"},
+{"&acy;","а"},
+{"&aelig","æ"},
 {"&aelig;","æ"},
 {"&af;","⁡"},
 {"&afr;","𝔞"},
@@ -741,31 +776,6 @@
 {"&boxDr;","╓"},
 {"&boxH;","═"},
 {"&boxHD;","╦"},
-{"&Yuml;","Ÿ"},
-{"&ZHcy;","Ж"},
-{"&Zacute;","Ź"},
-{"&Zcaron;","Ž"},
-{"&Zcy;","З"},
-{"&Zdot;","Ż"},
-{"&ZeroWidthSpace;","​"},
-{"&Zeta;","Ζ"},
-{"&Zfr;","ℨ"},
-{"&Zopf;","ℤ"},
-{"&Zscr;","𝒵"},
-{"&aacute","á"},
-{"&aacute;","á"},
-{"&abreve;","ă"},
-{"&ac;","∾"},
-{"&acE;","∾̳"},
-{"&acd;","∿"},
-{"&acirc","â"},
-{"&acirc;","â"},
-{"&acute","´"},
-{"&acute;","´"},
-{"&acy;","а"},
-{"&aelig","æ"},
-
-
 {"&boxHU;","╩"},
 {"&boxHd;","╤"},
 {"&boxHu;","╧"},
@@ -812,7 +822,7 @@
 {"&bsemi;","⁏"},
 {"&bsim;","∽"},
 {"&bsime;","⋍"},
-{"&bsol;","\""},
+{"&bsol;","\\"},
 {"&bsolb;","⧅"},
 {"&bsolhsub;","⟈"},
 {"&bull;","•"},
@@ -2233,127 +2243,4 @@
 {"&zscr;","𝓏"},
 {"&zwj;","‍"},
 {"&zwnj;","‌"},
-
-{"&aelig;","æ"},
-{"&af;","⁡"},
-{"&afr;","𝔞"},
-{"&agrave","à"},
-{"&agrave;","à"},
-{"&alefsym;","ℵ"},
-{"&aleph;","ℵ"},
-{"&alpha;","α"},
-{"&amacr;","ā"},
-{"&amalg;","⨿"},
-{"&amp","&"},
-{"&amp;","&"},
-{"&and;","∧"},
-{"&andand;","⩕"},
-{"&andd;","⩜"},
-{"&andslope;","⩘"},
-{"&andv;","⩚"},
-{"&ang;","∠"},
-{"&ange;","⦤"},
-{"&angle;","∠"},
-{"&angmsd;","∡"},
-{"&angmsdaa;","⦨"},
-{"&angmsdab;","⦩"},
-{"&angmsdac;","⦪"},
-{"&angmsdad;","⦫"},
-{"&angmsdae;","⦬"},
-{"&angmsdaf;","⦭"},
-{"&angmsdag;","⦮"},
-{"&angmsdah;","⦯"},
-{"&angrt;","∟"},
-{"&angrtvb;","⊾"},
-{"&angrtvbd;","⦝"},
-{"&angsph;","∢"},
-{"&angst;","Å"},
-{"&angzarr;","⍼"},
-{"&aogon;","ą"},
-{"&aopf;","𝕒"},
-{"&ap;","≈"},
-{"&apE;","⩰"},
-{"&apacir;","⩯"},
-{"&ape;","≊"},
-{"&apid;","≋"},
-{"&apos;","'"},
-{"&approx;","≈"},
-{"&approxeq;","≊"},
-{"&aring","å"},
-{"&aring;","å"},
-{"&ascr;","𝒶"},
-{"&ast;","*"},
-{"&asymp;","≈"},
-{"&asympeq;","≍"},
-{"&atilde","ã"},
-{"&atilde;","ã"},
-{"&auml","ä"},
-{"&auml;","ä"},
-{"&awconint;","∳"},
-{"&awint;","⨑"},
-{"&bNot;","⫭"},
-{"&backcong;","≌"},
-{"&backepsilon;","϶"},
-{"&backprime;","‵"},
-{"&backsim;","∽"},
-{"&backsimeq;","⋍"},
-{"&barvee;","⊽"},
-{"&barwed;","⌅"},
-{"&barwedge;","⌅"},
-{"&bbrk;","⎵"},
-{"&bbrktbrk;","⎶"},
-{"&bcong;","≌"},
-{"&bcy;","б"},
-{"&bdquo;","„"},
-{"&becaus;","∵"},
-{"&because;","∵"},
-{"&bemptyv;","⦰"},
-{"&bepsi;","϶"},
-{"&bernou;","ℬ"},
-{"&beta;","β"},
-{"&beth;","ℶ"},
-{"&between;","≬"},
-{"&bfr;","𝔟"},
-{"&bigcap;","⋂"},
-{"&bigcirc;","◯"},
-{"&bigcup;","⋃"},
-{"&bigodot;","⨀"},
-{"&bigoplus;","⨁"},
-{"&bigotimes;","⨂"},
-{"&bigsqcup;","⨆"},
-{"&bigstar;","★"},
-{"&bigtriangledown;","▽"},
-{"&bigtriangleup;","△"},
-{"&biguplus;","⨄"},
-{"&bigvee;","⋁"},
-{"&bigwedge;","⋀"},
-{"&bkarow;","⤍"},
-{"&blacklozenge;","⧫"},
-{"&blacksquare;","▪"},
-{"&blacktriangle;","▴"},
-{"&blacktriangledown;","▾"},
-{"&blacktriangleleft;","◂"},
-{"&blacktriangleright;","▸"},
-{"&blank;","␣"},
-{"&blk12;","▒"},
-{"&blk14;","░"},
-{"&blk34;","▓"},
-{"&block;","█"},
-{"&bne;","=⃥"},
-{"&bnequiv;","≡⃥"},
-{"&bnot;","⌐"},
-{"&bopf;","𝕓"},
-{"&bot;","⊥"},
-{"&bottom;","⊥"},
-{"&bowtie;","⋈"},
-{"&boxDL;","╗"},
-{"&boxDR;","╔"},
-{"&boxDl;","╖"},
-{"&boxDr;","╓"},
-{"&boxH;","═"},
-{"&boxHD;","╦"},
             };
-
-
-
-
@@ -0,0 +1,47 @@
+#pragma once
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+// Runs work until at least minSeconds have passed and returns the average
+// time of one run in seconds.
+template <typename Work>
+double secondsPerRun(Work &&work, double minSeconds = 0.5)
+{
+    using Clock = std::chrono::steady_clock;
+    work();
+    size_t runs = 0;
+    Clock::time_point start = Clock::now();
+    double elapsed = 0;
+    do
+    {
+        work();
+        ++runs;
+        elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    } while (elapsed < minSeconds);
+    return elapsed / static_cast<double>(runs);
+}
+
+// Throughput in MB/s of work processing bytes per run.
+template <typename Work>
+double megabytesPerSecond(size_t bytes, Work &&work, double minSeconds = 0.5)
+{
+    return static_cast<double>(bytes) / secondsPerRun(work, minSeconds) / 1e6;
+}
+
+inline void report(const std::string &name, double megabytes)
+{
+    std::printf("  %-32s %10.1f MB/s\n", name.c_str(), megabytes);
+}
+
+inline void reportTime(const std::string &name, double seconds)
+{
+    std::printf("  %-32s %10.1f us\n", name.c_str(), seconds * 1e6);
+}
+
+// Keeps the optimizer from discarding a result.
+template <typename T>
+void keep(const T &value)
+{
+    asm volatile("" : : "g"(&value) : "memory");
+}
@@ -0,0 +1,78 @@
+// Startup cost of the entity table: building the unordered_map that
+// knownEntities.hpp used to define at namespace scope (once per translation
+// unit, before main) against the constexpr array, which needs no work. Also
+// times lookups through each.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <malloc.h>
+#include "GigaWeb.hpp"
+#include "bench.hpp"
+
+static size_t heapInUse()
+{
+    return mallinfo2().uordblks;
+}
+
+static size_t residentKilobytes()
+{
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line))
+    {
+        if (line.compare(0, 6, "VmRSS:") == 0)
+            return std::strtoul(line.c_str() + 6, nullptr, 10);
+    }
+    return 0;
+}
+
+int main()
+{
+    size_t entries = sizeof(knownEntities) / sizeof(knownEntities[0]);
+    std::cout << entries << " entities" << std::endl;
+
+    size_t rssBefore = residentKilobytes();
+    size_t heapBefore = heapInUse();
+    auto start = std::chrono::steady_clock::now();
+    std::unordered_map<std::string, std::string> map;
+    for (const KnownEntity &entity : knownEntities)
+        map.emplace(std::string(entity.name), std::string(entity.value));
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("  unordered_map, per translation unit: %.0f us, %zu KB heap, %zu KB more RSS\n",
+                seconds * 1e6, (heapInUse() - heapBefore) / 1024, residentKilobytes() - rssBefore);
+    std::printf("  constexpr array, whole program:      0 us, no heap, %zu KB read-only data\n",
+                sizeof(knownEntities) / 1024);
+
+    std::string text;
+    for (size_t i = 0; i < entries; i += 7)
+        text += std::string(knownEntities[i].name) + " text ";
+    std::string out;
+    report("decode via unordered_map", megabytesPerSecond(text.size(), [&]()
+                                                          {
+        out.clear();
+        for (size_t p = 0; p < text.size();)
+        {
+            size_t amp = text.find('&', p);
+            size_t semi = amp == std::string::npos ? amp : text.find(';', amp);
+            if (semi == std::string::npos)
+            {
+                out.append(text, p, std::string::npos);
+                break;
+            }
+            out.append(text, p, amp - p);
+            auto it = map.find(text.substr(amp, semi - amp + 1));
+            out += it == map.end() ? text.substr(amp, semi - amp + 1) : it->second;
+            p = semi + 1;
+        }
+        keep(out); }));
+    report("GigaEntities::decode", megabytesPerSecond(text.size(), [&]()
+                                                      {
+        out.clear();
+        GigaEntities::decode(text, out);
+        keep(out); }));
+    return 0;
+}
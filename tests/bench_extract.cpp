@@ -0,0 +1,45 @@
+// Per-page cost of a compiled ExtractionPlan against the chain of GigaWeb
+// calls a hand-written scraper makes for the same fields.
+#include <iostream>
+#include "GigaWeb.hpp"
+#include "bench.hpp"
+#include "corpus.hpp"
+
+int main(int argc, char **argv)
+{
+    GigaWeb giga;
+    ExtractionSpec spec;
+    spec.text("title", "title").transform([&](const std::string &text)
+                                          { return giga.cleanTXT(text); });
+    spec.text("heading", "h1");
+    spec.attribute("link", "a", "href");
+    spec.text("items", "li", true);
+    spec.count("paragraphs", "p");
+    ExtractionPlan plan(spec);
+
+    for (const CorpusPage &page : loadCorpus(argc, argv))
+    {
+        std::cout << page.name << " (" << page.html.size() << " bytes)" << std::endl;
+
+        reportTime("chained calls", secondsPerRun([&]()
+                                                  {
+            std::string title = giga.cleanTXT(giga.extractContentBetweenTags(page.html, "<title>", "</title>"));
+            std::vector<std::string> heading = giga.getTagContents(page.html, "h1");
+            std::string link = giga.getAttributeValue(page.html, "a", "href");
+            std::vector<std::string> items = giga.getTagContents(page.html, "li");
+            int paragraphs = giga.countTagOccurrences(page.html, "p");
+            keep(title);
+            keep(heading);
+            keep(link);
+            keep(items);
+            keep(paragraphs); }));
+
+        reportTime("ExtractionPlan (native)", secondsPerRun([&]()
+                                                            { keep(plan.apply(std::string_view(page.html))); }));
+        reportTime("ExtractionPlan (gumbo)", secondsPerRun([&]()
+                                                           {
+            giga.setHtmlParser(HtmlParser::Gumbo);
+            keep(giga.extract(plan, page.html)); }));
+    }
+    return 0;
+}
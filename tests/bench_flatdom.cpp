@@ -0,0 +1,60 @@
+// Traversal of a parsed page: the recursive GumboNode walk the extractors
+// used to do against a linear scan of the FlatDom built from it.
+#include <iostream>
+#include "GigaWeb.hpp"
+#include "bench.hpp"
+#include "corpus.hpp"
+
+static size_t gumboTextBytes(const GumboNode *node)
+{
+    if (node->type == GUMBO_NODE_TEXT)
+        return std::strlen(node->v.text.text);
+    if (node->type != GUMBO_NODE_ELEMENT)
+        return 0;
+    if (node->v.element.tag == GUMBO_TAG_SCRIPT || node->v.element.tag == GUMBO_TAG_STYLE)
+        return 0;
+    size_t bytes = 0;
+    const GumboVector &children = node->v.element.children;
+    for (unsigned int i = 0; i < children.length; ++i)
+        bytes += gumboTextBytes(static_cast<const GumboNode *>(children.data[i]));
+    return bytes;
+}
+
+static size_t flatTextBytes(const FlatDom &dom)
+{
+    size_t bytes = 0;
+    for (uint32_t i = 0; i < dom.size();)
+    {
+        const DomNode &node = dom[i];
+        if (node.tag == GUMBO_TAG_SCRIPT || node.tag == GUMBO_TAG_STYLE)
+        {
+            i = node.subtreeEnd;
+            continue;
+        }
+        if (node.type == GUMBO_NODE_TEXT)
+            bytes += node.text.length;
+        ++i;
+    }
+    return bytes;
+}
+
+int main(int argc, char **argv)
+{
+    for (const CorpusPage &page : loadCorpus(argc, argv))
+    {
+        GigaWeb::Document document(page.html);
+        const FlatDom &dom = document.dom();
+        std::cout << page.name << " (" << page.html.size() << " bytes, " << dom.size() << " nodes)" << std::endl;
+        size_t bytes = page.html.size();
+
+        report("recursive Gumbo walk", megabytesPerSecond(bytes, [&]()
+                                                          { keep(gumboTextBytes(document.root())); }));
+        report("FlatDom scan", megabytesPerSecond(bytes, [&]()
+                                                  { keep(flatTextBytes(dom)); }));
+        GumboOutput *output = gumbo_parse_with_options(&kGumboDefaultOptions, page.html.data(), page.html.size());
+        report("FlatDom::fromGumbo", megabytesPerSecond(bytes, [&]()
+                                                        { keep(FlatDom::fromGumbo(output, page.html)); }));
+        gumbo_destroy_output(&kGumboDefaultOptions, output);
+    }
+    return 0;
+}
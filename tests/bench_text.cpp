@@ -0,0 +1,63 @@
+// Text helpers against the regex implementations they replaced, on a few
+// MB of generated prose and markup.
+#include <iostream>
+#include "GigaWeb.hpp"
+#include "bench.hpp"
+#include "corpus.hpp"
+#include "reference.hpp"
+
+static std::string prose(size_t bytes)
+{
+    std::string text;
+    while (text.size() < bytes)
+        text += "Lorem ipsum dolor sit amet,  consectetur\t adipiscing elit. \n\n  Sed do eiusmod tempor. ";
+    return text;
+}
+
+int main(int argc, char **argv)
+{
+    GigaWeb giga;
+    std::string text = prose(8 << 20);
+    std::string buffer(text.size(), '\0');
+    std::cout << "cleanTXT (" << text.size() << " bytes)" << std::endl;
+    report("regex", megabytesPerSecond(text.size(), [&]()
+                                       { keep(reference::cleanTXT(text)); }));
+    report("cleanTXT", megabytesPerSecond(text.size(), [&]()
+                                          { keep(giga.cleanTXT(text)); }));
+    report("cleanTXT into a buffer", megabytesPerSecond(text.size(), [&]()
+                                                        { keep(giga.cleanTXT(text.data(), text.size(), &buffer[0])); }));
+
+    for (const CorpusPage &page : loadCorpus(argc, argv))
+    {
+        std::cout << "cleanHTML, " << page.name << " (" << page.html.size() << " bytes)" << std::endl;
+        buffer.resize(page.html.size());
+        report("regex", megabytesPerSecond(page.html.size(), [&]()
+                                           { keep(reference::cleanHTML(page.html)); }));
+        report("cleanHTML", megabytesPerSecond(page.html.size(), [&]()
+                                               { keep(giga.cleanHTML(page.html)); }));
+        report("cleanHTML into a buffer", megabytesPerSecond(page.html.size(), [&]()
+                                                             { keep(giga.cleanHTML(page.html.data(), page.html.size(), &buffer[0])); }));
+    }
+
+    std::string output;
+    for (const CorpusPage &page : loadCorpus(argc, argv))
+    {
+        std::cout << "htmlToText, " << page.name << " (" << page.html.size() << " bytes)" << std::endl;
+        report("chained calls", megabytesPerSecond(page.html.size(), [&]()
+                                                   {
+            std::string copy = giga.removeScriptAndStyleTags(page.html);
+            copy = giga.removePathAndSvgTags(copy);
+            copy = giga.removeAllCommentsFromHTML(copy);
+            copy = giga.cleanHTML(copy);
+            copy = giga.encodeHtmlEntities(copy);
+            keep(giga.cleanTXT(copy)); }));
+        report("htmlToText", megabytesPerSecond(page.html.size(), [&]()
+                                                { keep(giga.htmlToText(page.html)); }));
+        report("htmlToText, reused buffer", megabytesPerSecond(page.html.size(), [&]()
+                                                               {
+            output.clear();
+            giga.htmlToText(page.html, output);
+            keep(output); }));
+    }
+    return 0;
+}
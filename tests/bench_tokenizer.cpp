@@ -0,0 +1,39 @@
+// Throughput of the native tokenizer path against the Gumbo parse it
+// replaces for content extraction.
+#include <iostream>
+#include "GigaWeb.hpp"
+#include "bench.hpp"
+#include "corpus.hpp"
+
+int main(int argc, char **argv)
+{
+    GigaWeb giga;
+    for (const CorpusPage &page : loadCorpus(argc, argv))
+    {
+        std::cout << page.name << " (" << page.html.size() << " bytes)" << std::endl;
+        size_t bytes = page.html.size();
+
+        report("tokens", megabytesPerSecond(bytes, [&]()
+                                            {
+            GigaTokenizer tokenizer(page.html);
+            HtmlToken token;
+            size_t count = 0;
+            while (tokenizer.next(token))
+                ++count;
+            keep(count); }));
+        report("GigaTokenizer::toFlatDom", megabytesPerSecond(bytes, [&]()
+                                                              { keep(GigaTokenizer::toFlatDom(page.html)); }));
+        report("Gumbo parse + FlatDom", megabytesPerSecond(bytes, [&]()
+                                                           {
+            GigaWeb::Document document(page.html);
+            keep(document.dom()); }));
+
+        giga.setHtmlParser(HtmlParser::Native);
+        report("getMainContent (native)", megabytesPerSecond(bytes, [&]()
+                                                             { keep(giga.getMainContent(page.html)); }));
+        giga.setHtmlParser(HtmlParser::Gumbo);
+        report("getMainContent (gumbo)", megabytesPerSecond(bytes, [&]()
+                                                            { keep(giga.getMainContent(page.html)); }));
+    }
+    return 0;
+}
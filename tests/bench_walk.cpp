@@ -0,0 +1,54 @@
+// Extractor walks on deep and wide pages: the recursive GumboNode walk with
+// a std::string copy and std::count per text node that the extractors used
+// to do, against the flat scan over views they do now.
+#include <algorithm>
+#include <iostream>
+#include "GigaWeb.hpp"
+#include "bench.hpp"
+#include "corpus.hpp"
+
+static void recursiveMultipleContents(GumboNode *node, std::vector<std::string> &contents)
+{
+    if (node->type == GUMBO_NODE_TEXT)
+    {
+        std::string text(node->v.text.text);
+        size_t word_count = std::count(text.begin(), text.end(), ' ') + 1;
+        if (word_count > 20)
+            contents.push_back(text);
+    }
+    else if (node->type == GUMBO_NODE_ELEMENT && node->v.element.tag != GUMBO_TAG_SCRIPT &&
+             node->v.element.tag != GUMBO_TAG_STYLE && node->v.element.tag != GUMBO_TAG_HEADER &&
+             node->v.element.tag != GUMBO_TAG_FOOTER && node->v.element.tag != GUMBO_TAG_NAV &&
+             node->v.element.tag != GUMBO_TAG_ASIDE)
+    {
+        GumboVector *children = &node->v.element.children;
+        for (unsigned int i = 0; i < children->length; ++i)
+            recursiveMultipleContents(static_cast<GumboNode *>(children->data[i]), contents);
+    }
+}
+
+int main()
+{
+    // Deep enough to matter, shallow enough for the recursive walk to
+    // survive on the main thread.
+    std::vector<CorpusPage> pages = {{"deep (5000 levels)", deepPage(5000)}, {"wide (50000 paragraphs)", widePage(50000)}};
+    ExtractionPolicy policy = ExtractionPolicy::multipleContents();
+    policy.dedup = false;
+
+    for (const CorpusPage &page : pages)
+    {
+        GigaWeb::Document document(page.html);
+        std::cout << page.name << " (" << page.html.size() << " bytes, " << document.dom().size() << " nodes)" << std::endl;
+
+        reportTime("recursive walk + copies", secondsPerRun([&]()
+                                                            {
+            std::vector<std::string> contents;
+            recursiveMultipleContents(document.root(), contents);
+            keep(contents); }));
+        reportTime("flat scan over views", secondsPerRun([&]()
+                                                         { keep(document.multipleContents(policy)); }));
+        reportTime("links(), explicit stack", secondsPerRun([&]()
+                                                            { keep(document.links()); }));
+    }
+    return 0;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <iostream>
+#include <sstream>
+#include <string>
+
+// Minimal assertions for the tests: a failed check prints where and what,
+// and checkResult() turns the failure count into the exit status.
+inline int &checkFailures()
+{
+    static int failures = 0;
+    return failures;
+}
+
+template <typename A, typename B>
+void checkEqual(const A &actual, const B &expected, const char *expression, const char *file, int line)
+{
+    if (actual == expected)
+        return;
+    ++checkFailures();
+    std::ostringstream message;
+    message << file << ":" << line << ": " << expression << "\n  actual:   " << actual << "\n  expected: " << expected;
+    std::cerr << message.str() << std::endl;
+}
+
+inline void checkTrue(bool condition, const char *expression, const char *file, int line)
+{
+    if (condition)
+        return;
+    ++checkFailures();
+    std::cerr << file << ":" << line << ": " << expression << std::endl;
+}
+
+#define CHECK(condition) checkTrue((condition), #condition, __FILE__, __LINE__)
+#define CHECK_EQ(actual, expected) checkEqual((actual), (expected), #actual " == " #expected, __FILE__, __LINE__)
+
+inline int checkResult()
+{
+    if (checkFailures())
+        std::cerr << checkFailures() << " check(s) failed" << std::endl;
+    else
+        std::cout << "ok" << std::endl;
+    return checkFailures() ? 1 : 0;
+}
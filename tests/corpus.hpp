@@ -0,0 +1,126 @@
+#pragma once
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Pages used by the differential tests and the benchmarks: the files named
+// on the command line, or generated article pages when there are none. The
+// generated pages are well formed, so Gumbo's tree repair changes nothing
+// and both parsers must see the same text.
+struct CorpusPage
+{
+    std::string name;
+    std::string html;
+};
+
+inline std::string articlePage(size_t paragraphs, unsigned seed)
+{
+    static const char *const words[] = {"crawler", "page", "index", "text", "search", "node", "buffer", "token",
+                                        "parser", "content", "link", "queue", "host", "cache", "stream", "value"};
+    unsigned state = seed * 2654435761u + 1;
+    auto word = [&]()
+    {
+        state = state * 1103515245u + 12345u;
+        return words[(state >> 16) % (sizeof(words) / sizeof(words[0]))];
+    };
+    auto sentence = [&](size_t count)
+    {
+        std::string text;
+        for (size_t i = 0; i < count; ++i)
+        {
+            text += i ? " " : "";
+            text += word();
+            if (i % 7 == 6)
+                text += ",";
+        }
+        return text;
+    };
+
+    std::string html = "<!DOCTYPE html>\n<html lang=\"en\"><head><meta charset=\"utf-8\"><title>Report &amp; notes " +
+                       std::to_string(seed) + "</title>\n";
+    html += "<style>body > p { margin: 0 } a[href^='http'] { color: red }</style>\n";
+    html += "<script>var markup = '<p>not text</p>'; if (a < b && b > c) { load(); }</script>\n";
+    html += "</head>\n<body>\n<!-- page header -->\n";
+    html += "<header><nav class=\"menu\"><ul><li><a href=\"/\">Home</a></li><li><a href=\"/about?x=1&amp;y=2\">About</a></li></ul></nav></header>\n";
+    html += "<div id=\"main\" class=\"content\"><article>\n<h1 title=\"a > b\">" + sentence(6) + "</h1>\n";
+    for (size_t i = 0; i < paragraphs; ++i)
+    {
+        switch (i % 5)
+        {
+        case 0:
+            html += "<p>" + sentence(30) + " &copy; 2024 &#8212; " + sentence(12) + ".</p>\n";
+            break;
+        case 1:
+            html += "<p class='lead'>" + sentence(18) + " <a href=\"/p/" + std::to_string(i) + "\">" + sentence(3) + "</a> " +
+                    sentence(20) + " &lt;tag&gt; " + sentence(5) + ".</p>\n";
+            break;
+        case 2:
+            html += "<ul><li>" + sentence(8) + "</li><li>" + sentence(9) + "</li><li>" + sentence(7) + "</li></ul>\n";
+            break;
+        case 3:
+            html += "<table><tbody><tr><td>" + sentence(4) + "</td><td>" + sentence(5) + "</td></tr><tr><td>" + sentence(3) +
+                    "</td><td>" + sentence(6) + "</td></tr></tbody></table>\n";
+            break;
+        default:
+            html += "<blockquote><p>" + sentence(25) + " <em>" + sentence(4) + "</em> " + sentence(10) +
+                    ".</p></blockquote>\n<!-- <p>commented out</p> -->\n";
+            break;
+        }
+    }
+    html += "</article></div>\n";
+    html += "<aside class=\"sidebar\"><p>" + sentence(12) + "</p></aside>\n";
+    html += "<footer><p>Contact &nbsp;<a href=\"mailto:x@example.com\">" + sentence(2) + "</a></p></footer>\n";
+    html += "<script type=\"text/javascript\">document.write('</p>');</script>\n</body></html>\n";
+    return html;
+}
+
+// depth nested elements, each with a little text, and a paragraph at the
+// bottom: the shape that overflows recursive walkers.
+inline std::string deepPage(size_t depth)
+{
+    std::string html = "<html><body>";
+    for (size_t i = 0; i < depth; ++i)
+        html += i % 2 ? "<span>level " + std::to_string(i) + " " : "<div><a href=\"/" + std::to_string(i) + "\">x</a>";
+    html += "<p>the deepest paragraph holds the longest text of the whole page, twenty five words long, so every "
+            "extractor should return it from the bottom of the tree.</p>";
+    for (size_t i = depth; i-- > 0;)
+        html += i % 2 ? "</span>" : "</div>";
+    html += "</body></html>";
+    return html;
+}
+
+// count sibling paragraphs of a few words each.
+inline std::string widePage(size_t count)
+{
+    std::string html = "<html><body><div>";
+    for (size_t i = 0; i < count; ++i)
+        html += "<p>paragraph " + std::to_string(i) + " with a handful of words and one <b>bold</b> part in it</p>";
+    html += "</div></body></html>";
+    return html;
+}
+
+inline std::vector<CorpusPage> loadCorpus(int argc, char **argv)
+{
+    std::vector<CorpusPage> pages;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::ifstream file(argv[i], std::ios::binary);
+        if (!file)
+        {
+            std::cerr << "cannot read " << argv[i] << std::endl;
+            continue;
+        }
+        std::ostringstream content;
+        content << file.rdbuf();
+        pages.push_back({argv[i], content.str()});
+    }
+    if (argc > 1)
+        return pages;
+
+    pages.push_back({"small article", articlePage(10, 1)});
+    pages.push_back({"medium article", articlePage(200, 2)});
+    pages.push_back({"large article", articlePage(5000, 3)});
+    return pages;
+}
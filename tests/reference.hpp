@@ -0,0 +1,55 @@
+#pragma once
+#include <regex>
+#include <string>
+#include <unordered_set>
+#include "knownEntities.hpp"
+
+// The regex implementations the single-pass versions replaced, kept as the
+// reference their output is checked and benchmarked against.
+namespace reference
+{
+    inline std::string cleanTXT(const std::string &input)
+    {
+        static const std::regex spacePattern("[ \t]+");
+        static const std::regex newlinePattern("[ \t]*\n[ \t]*");
+        static const std::regex trimPattern("^\\s+|\\s+$");
+        static const std::regex multiNewlinePattern("\n+");
+
+        std::string output = std::regex_replace(input, spacePattern, " ");
+        output = std::regex_replace(output, newlinePattern, "\n");
+        output = std::regex_replace(output, trimPattern, "");
+        output = std::regex_replace(output, multiNewlinePattern, "\n");
+        return output;
+    }
+
+    inline std::string cleanHTML(const std::string &html)
+    {
+        static const std::regex tagRegex("<[^>]+>");
+        return std::regex_replace(html, tagRegex, "");
+    }
+
+    inline std::string removeHtmlEntities(const std::string &html)
+    {
+        static const std::regex htmlEntitiesPattern(R"(&\w+;)");
+        static const std::unordered_set<std::string_view> names = []
+        {
+            std::unordered_set<std::string_view> set;
+            for (const KnownEntity &entity : knownEntities)
+                set.insert(entity.name);
+            return set;
+        }();
+
+        std::string cleanedHtml;
+        std::string::const_iterator searchStart = html.begin();
+        for (std::sregex_iterator i(html.begin(), html.end(), htmlEntitiesPattern), end; i != end; ++i)
+        {
+            if (names.count(i->str()))
+            {
+                cleanedHtml.append(searchStart, html.begin() + i->position());
+                searchStart = html.begin() + i->position() + i->length();
+            }
+        }
+        cleanedHtml.append(searchStart, html.end());
+        return cleanedHtml;
+    }
+}
@@ -0,0 +1,89 @@
+// GigaEntities and the constexpr knownEntities table: every entry decodes to
+// its value, and the HTML5 rules for legacy names, numeric references and
+// attribute values hold. removeHtmlEntities keeps the regex version's rules.
+#include <random>
+#include <string>
+#include "GigaWeb.hpp"
+#include "check.hpp"
+#include "reference.hpp"
+
+static std::string decode(std::string_view text, bool attribute = false)
+{
+    std::string out;
+    GigaEntities::decode(text, out, attribute);
+    return out;
+}
+
+static void testTable()
+{
+    size_t entries = sizeof(knownEntities) / sizeof(knownEntities[0]);
+    CHECK(entries > 2200);
+    for (const KnownEntity &entity : knownEntities)
+    {
+        CHECK(entity.name.size() > 1 && entity.name[0] == '&');
+        std::string decoded = decode(entity.name);
+        if (decoded != entity.value)
+            CHECK_EQ(std::string(entity.name) + " -> " + decoded, std::string(entity.name) + " -> " + std::string(entity.value));
+    }
+    CHECK_EQ(decode("&bsol;"), "\\");
+    CHECK_EQ(decode("&NewLine;"), "\n");
+}
+
+static void testNamed()
+{
+    CHECK_EQ(decode("a &amp; b &lt;c&gt;"), "a & b <c>");
+    CHECK_EQ(decode("&copy 2024"), "© 2024");
+    CHECK_EQ(decode("&notin; &notit;"), "∉ ¬it;");
+    CHECK_EQ(decode("&nosuch; & &;"), "&nosuch; & &;");
+    CHECK_EQ(decode("&CounterClockwiseContourIntegral;"), "∳");
+    CHECK_EQ(decode("trailing &"), "trailing &");
+}
+
+static void testNumeric()
+{
+    CHECK_EQ(decode("&#65;&#x42;&#X43;&#68"), "ABCD");
+    CHECK_EQ(decode("&#128;&#x9F;"), "€Ÿ");
+    CHECK_EQ(decode("&#0;&#xD800;&#x110000;&#99999999999;"), "����");
+    CHECK_EQ(decode("&#x1F600;"), "\U0001F600");
+    CHECK_EQ(decode("&#;&#x;"), "&#;&#x;");
+}
+
+static void testAttribute()
+{
+    CHECK_EQ(decode("?a=1&copy=2&amp;b", true), "?a=1&copy=2&b");
+    CHECK_EQ(decode("&copyx &copy;", true), "&copyx ©");
+    CHECK_EQ(decode("&copy=2", false), "©=2");
+}
+
+static void testGigaWeb()
+{
+    GigaWeb giga;
+    CHECK_EQ(giga.encodeHtmlEntities("&lt;p&gt; &eacute;t&eacute; &#x2014;"), "<p> été —");
+    CHECK_EQ(giga.removeHtmlEntities("a&nbsp;b &amp c &bogus;"), "ab &amp c &bogus;");
+    CHECK_EQ(giga.removeHtmlEntities("&#65;&#x42; &copy 2024 &copy;&amp_; &&lt;"), "&#65;&#x42; &copy 2024 &amp_; &");
+
+    static const char *const pieces[] = {"&amp;", "&amp", "&nbsp;", "&#65;", "&#x42;", "&bogus;", "&", ";", "a", " ", "_",
+                                         "&copy", "&notin;", "&not", "in;", "&CounterClockwiseContourIntegral;", "&lt"};
+    std::mt19937 random(23);
+    for (int i = 0; i < 20000; ++i)
+    {
+        std::string text;
+        for (size_t n = random() % 12; n > 0; --n)
+            text += pieces[random() % (sizeof(pieces) / sizeof(pieces[0]))];
+        CHECK_EQ(giga.removeHtmlEntities(text), reference::removeHtmlEntities(text));
+    }
+
+    HtmlToTextOptions remove;
+    remove.entities = EntityMode::Remove;
+    CHECK_EQ(giga.htmlToText("<p>a&nbsp;b &amp c &#65;</p>", remove), "ab &amp c &#65;");
+}
+
+int main()
+{
+    testTable();
+    testNamed();
+    testNumeric();
+    testAttribute();
+    testGigaWeb();
+    return checkResult();
+}
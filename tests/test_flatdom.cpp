@@ -0,0 +1,116 @@
+// FlatDom: the builder API, the 31-bit source limit, and fromGumbo mirroring
+// the Gumbo tree node for node over the corpus.
+#include <string>
+#include <string_view>
+#include "GigaWeb.hpp"
+#include "check.hpp"
+#include "corpus.hpp"
+
+static void testBuilder()
+{
+    std::string source = "<div id=a>x &amp; y</div>";
+    FlatDom dom(source);
+    uint32_t div = dom.beginElement(GUMBO_TAG_DIV);
+    dom.addAttribute(std::string_view(source).substr(5, 2), std::string_view(source).substr(8, 1));
+    uint32_t text = dom.addNode(GUMBO_NODE_TEXT, "x & y");
+    dom.endElement();
+    uint32_t custom = dom.beginElement(GUMBO_TAG_UNKNOWN, "my-widget");
+    dom.finish();
+
+    CHECK_EQ(dom.size(), 4u);
+    CHECK_EQ(dom[0].firstChild, div);
+    CHECK_EQ(dom[div].nextSibling, custom);
+    CHECK_EQ(dom[div].firstChild, text);
+    CHECK_EQ(dom[text].parent, div);
+    CHECK_EQ(dom[div].subtreeEnd, 3u);
+    CHECK_EQ(dom[0].subtreeEnd, 4u);
+    CHECK_EQ(dom[custom].subtreeEnd, 4u);
+    CHECK_EQ(std::string(dom.text(text)), "x & y");
+    CHECK_EQ(std::string(dom.tagName(custom)), "my-widget");
+
+    std::string_view value;
+    CHECK(dom.attribute(div, "ID", value) && value == "a");
+    CHECK_EQ(dom[div].attributeCount, 1u);
+    // Views into the source are referenced, other text is copied to the pool.
+    CHECK(!(dom.attributesBegin(div)->name.offset & DomString::kPooled));
+    CHECK(dom[text].text.offset & DomString::kPooled);
+    CHECK_EQ(dom.textContent(0), "x & y");
+}
+
+static void testSourceLimit()
+{
+    // Never read: an oversized source is refused before it is scanned.
+    std::string_view huge("", FlatDom::kMaxSource + 1);
+    FlatDom dom = GigaTokenizer::toFlatDom(huge);
+    CHECK_EQ(dom.size(), 1u);
+    CHECK_EQ(dom[0].firstChild, DomNode::kNone);
+    CHECK(FlatDom::fits(std::string_view("", FlatDom::kMaxSource)));
+}
+
+// Walks the Gumbo tree in preorder alongside the flat nodes.
+static void compare(const FlatDom &dom, const GumboNode *node, uint32_t &index, uint32_t parent)
+{
+    uint32_t self = index++;
+    if (self >= dom.size())
+    {
+        CHECK(self < dom.size());
+        return;
+    }
+    const DomNode &flat = dom[self];
+    CHECK_EQ(flat.parent, parent);
+    CHECK_EQ(static_cast<int>(flat.type), static_cast<int>(node->type));
+
+    if (node->type == GUMBO_NODE_ELEMENT || node->type == GUMBO_NODE_TEMPLATE)
+    {
+        const GumboElement &element = node->v.element;
+        CHECK_EQ(flat.tag, static_cast<uint16_t>(element.tag));
+        CHECK_EQ(flat.attributeCount, element.attributes.length);
+        for (unsigned int i = 0; i < element.attributes.length; ++i)
+        {
+            const GumboAttribute *attr = static_cast<const GumboAttribute *>(element.attributes.data[i]);
+            std::string_view value;
+            CHECK(dom.attribute(self, attr->name, value));
+            CHECK_EQ(std::string(value), std::string(attr->value));
+        }
+        uint32_t previous = DomNode::kNone;
+        for (unsigned int i = 0; i < element.children.length; ++i)
+        {
+            uint32_t child = index;
+            if (previous == DomNode::kNone)
+                CHECK_EQ(flat.firstChild, child);
+            else
+                CHECK_EQ(dom[previous].nextSibling, child);
+            compare(dom, static_cast<const GumboNode *>(element.children.data[i]), index, self);
+            previous = child;
+        }
+    }
+    else
+    {
+        CHECK_EQ(std::string(dom.text(self)), std::string(node->v.text.text));
+    }
+    CHECK_EQ(flat.subtreeEnd, index);
+}
+
+static void testAgainstGumbo(const std::vector<CorpusPage> &pages)
+{
+    for (const CorpusPage &page : pages)
+    {
+        GigaWeb::Document document(page.html);
+        const FlatDom &dom = document.dom();
+        GumboOutput *output = gumbo_parse(page.html.c_str());
+        uint32_t index = 1;
+        const GumboVector &children = output->document->v.document.children;
+        for (unsigned int i = 0; i < children.length; ++i)
+            compare(dom, static_cast<const GumboNode *>(children.data[i]), index, 0);
+        CHECK_EQ(index, static_cast<uint32_t>(dom.size()));
+        gumbo_destroy_output(&kGumboDefaultOptions, output);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    testBuilder();
+    testSourceLimit();
+    testAgainstGumbo(loadCorpus(argc, argv));
+    return checkResult();
+}
@@ -0,0 +1,152 @@
+// GigaStreamParser: any chunking of a page gives the same callbacks as
+// feeding it whole, and long comments or tags split over many chunks are
+// neither buffered whole (comments) nor rescanned per chunk (tags).
+#include <random>
+#include <string>
+#include "GigaStream.hpp"
+#include "check.hpp"
+
+// Callbacks as one string; text and comment pieces are joined first.
+class Recorder
+{
+public:
+    std::string events;
+    size_t maxBuffered = 0;
+
+    GigaStreamHandler handler()
+    {
+        GigaStreamHandler handler;
+        handler.onText = [this](std::string_view text, bool)
+        {
+            flushComment();
+            this->text += text;
+        };
+        handler.onComment = [this](std::string_view comment)
+        {
+            flushText();
+            this->comment += comment;
+            inComment = true;
+        };
+        handler.onStartTag = [this](const HtmlToken &token)
+        {
+            flush();
+            events += "<" + std::string(token.name) + ">";
+        };
+        handler.onAttribute = [this](const HtmlToken &, std::string_view name, std::string_view value)
+        { events += "@" + std::string(name) + "=" + std::string(value); };
+        handler.onEndTag = [this](const HtmlToken &token)
+        {
+            flush();
+            events += "</" + std::string(token.name) + ">";
+        };
+        return handler;
+    }
+
+    void flush()
+    {
+        flushText();
+        flushComment();
+    }
+
+private:
+    std::string text;
+    std::string comment;
+    bool inComment = false;
+
+    void flushText()
+    {
+        if (!text.empty())
+            events += "T[" + text + "]";
+        text.clear();
+    }
+
+    void flushComment()
+    {
+        if (inComment)
+            events += "C[" + comment + "]";
+        comment.clear();
+        inComment = false;
+    }
+};
+
+// Feeds html in chunks of chunk bytes, or of random sizes when chunk is 0.
+static std::string parse(const std::string &html, size_t chunk, std::mt19937 &random)
+{
+    Recorder recorder;
+    GigaStreamParser parser(recorder.handler());
+    for (size_t i = 0; i < html.size();)
+    {
+        size_t n = std::min(chunk ? chunk : 1 + random() % 40, html.size() - i);
+        parser.feed(html.data() + i, n);
+        recorder.maxBuffered = std::max(recorder.maxBuffered, parser.getBuffered());
+        i += n;
+    }
+    parser.finish();
+    recorder.flush();
+    return recorder.events;
+}
+
+static void testChunking()
+{
+    static const char *const pieces[] = {"<a href=\"x&amp;y\">", "</a>", "<div class='c>d'>", "</div>", "text &amp; more ", "&lt;",
+                                         "&copy", "<!-- c <p> -->", "<script>if(a<b && c</x){}</script>", "<style>p>a{}</STYLE >",
+                                         "<br/>", "<!DOCTYPE html>", "<", "</", "& ", "&#x41;", "<title>A &amp; B</title>",
+                                         "<![CDATA[x]]>", "<?php x ?>", "</>", "plain words here ", "<img alt=Bob's>", "<!-->",
+                                         "<!--->", "<p title = \"a>b\">"};
+    std::mt19937 random(17);
+    for (int i = 0; i < 5000; ++i)
+    {
+        std::string html;
+        for (size_t n = random() % 40; n > 0; --n)
+            html += pieces[random() % (sizeof(pieces) / sizeof(pieces[0]))];
+        std::string whole = parse(html, html.size() + 1, random);
+        CHECK_EQ(parse(html, 0, random), whole);
+        CHECK_EQ(parse(html, 1, random), whole);
+    }
+}
+
+static void testLongConstructs()
+{
+    const size_t size = 4 << 20;
+    std::string filler(size, 'x');
+
+    // A comment is reported in pieces as it arrives, so little is buffered.
+    size_t commentBytes = 0;
+    GigaStreamHandler handler;
+    handler.onComment = [&](std::string_view comment)
+    { commentBytes += comment.size(); };
+    GigaStreamParser comments(handler);
+    std::string html = "<!--" + filler + "-->";
+    size_t maxBuffered = 0;
+    for (size_t i = 0; i < html.size(); i += 512)
+    {
+        comments.feed(std::string_view(html).substr(i, 512));
+        maxBuffered = std::max(maxBuffered, comments.getBuffered());
+    }
+    comments.finish();
+    CHECK_EQ(commentBytes, size);
+    CHECK(maxBuffered < 1024);
+
+    // A huge tag has to be buffered, but each chunk only scans the new
+    // bytes; rescanning from '<' on every 512-byte chunk would read ~16 GB.
+    size_t valueSize = 0;
+    handler = GigaStreamHandler();
+    handler.onAttribute = [&](const HtmlToken &, std::string_view name, std::string_view value)
+    {
+        if (name == "title")
+            valueSize = value.size();
+    };
+    GigaStreamParser tags(handler);
+    html = "<a title=\"" + filler + "\" data-x='>'>";
+    for (size_t i = 0; i < html.size(); i += 512)
+        tags.feed(std::string_view(html).substr(i, 512));
+    tags.finish();
+    CHECK_EQ(valueSize, size);
+}
+
+int main()
+{
+    testChunking();
+    testLongConstructs();
+    return checkResult();
+}
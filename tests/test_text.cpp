@@ -0,0 +1,149 @@
+// Text helpers checked against the code they replaced (the regex versions,
+// the chain of calls htmlToText fuses), on fixed cases, random input and the
+// corpus.
+#include <random>
+#include <string>
+#include "GigaWeb.hpp"
+#include "check.hpp"
+#include "corpus.hpp"
+#include "reference.hpp"
+
+static const GigaScan::Level kLevels[] = {GigaScan::Level::Scalar, GigaScan::Level::SSE2, GigaScan::Level::AVX2};
+
+// Random text over alphabet, of up to maxLength bytes.
+static std::string randomText(std::mt19937 &random, const std::string &alphabet, size_t maxLength)
+{
+    std::string text(random() % (maxLength + 1), ' ');
+    for (char &c : text)
+        c = alphabet[random() % alphabet.size()];
+    return text;
+}
+
+static void testCleanTXT(GigaWeb &giga)
+{
+    CHECK_EQ(giga.cleanTXT("  a \t b \n\n c  "), "a b\nc");
+    CHECK_EQ(giga.cleanTXT("\r\n\tline one \r\n line two\v"), "line one \r\nline two");
+    CHECK_EQ(giga.cleanTXT(" \n\t "), "");
+    CHECK_EQ(giga.cleanTXT(""), "");
+
+    std::mt19937 random(21);
+    for (GigaScan::Level level : kLevels)
+    {
+        GigaScan::setLevel(level);
+        for (int i = 0; i < 20000; ++i)
+        {
+            std::string text = randomText(random, "ab  \t\n\r\v\f x", 300);
+            std::string expected = reference::cleanTXT(text);
+            CHECK_EQ(giga.cleanTXT(text), expected);
+
+            std::string inPlace = text;
+            giga.cleanTXTInPlace(inPlace);
+            CHECK_EQ(inPlace, expected);
+        }
+    }
+    GigaScan::setLevel(GigaScan::detectLevel());
+}
+
+static void testCleanHTML(GigaWeb &giga)
+{
+    CHECK_EQ(giga.cleanHTML("<p class=\"a>b\">one</p><!-- x > y -->two"), "onetwo");
+    CHECK_EQ(giga.cleanHTML("<p>1 < 2 &amp; 3</p>"), "1 < 2 &amp; 3");
+    CHECK_EQ(giga.cleanHTML("<![CDATA[x>y]]>z<!DOCTYPE html>"), "z");
+    CHECK_EQ(giga.cleanHTML("<script>var x=1;</script>keep<style>p{}</style>"), "var x=1;keepp{}");
+    CHECK_EQ(giga.cleanHTML("<title>a<b></title>"), "a<b>");
+    CHECK_EQ(giga.cleanHTML("<p>a</p><p>b</p>c<br>d", true), "a\nb\nc\nd");
+
+    std::string html = "<div id=x>in <b>place</b></div>";
+    html.resize(giga.cleanHTML(html.data(), html.size(), &html[0]));
+    CHECK_EQ(html, "in place");
+
+    // On markup without quoted '>', comments or stray '<' the regex was
+    // right, so the outputs must match.
+    static const char *const pieces[] = {"<p>", "</p>", "<a href=\"/x?a=1&amp;b\">", "</a>", "<br/>", "<img src='i.png' alt=''>",
+                                         "<div\nclass=\"c\">", "</div>", "text ", "more words", "&lt;", "\n", "<script>s=1;</script>"};
+    std::mt19937 random(22);
+    for (int i = 0; i < 5000; ++i)
+    {
+        std::string page;
+        for (size_t n = random() % 40; n > 0; --n)
+            page += pieces[random() % (sizeof(pieces) / sizeof(pieces[0]))];
+        CHECK_EQ(giga.cleanHTML(page), reference::cleanHTML(page));
+    }
+}
+
+// The calls htmlToText fuses.
+static std::string chained(GigaWeb &giga, const std::string &html, bool blockNewlines)
+{
+    std::string text = giga.removeScriptAndStyleTags(html);
+    text = giga.removePathAndSvgTags(text);
+    text = giga.removeAllCommentsFromHTML(text);
+    text = giga.cleanHTML(text, blockNewlines);
+    text = giga.encodeHtmlEntities(text);
+    return giga.cleanTXT(text);
+}
+
+static void testHtmlToText(GigaWeb &giga)
+{
+    HtmlToTextOptions lines;
+    lines.blockNewlines = true;
+    CHECK_EQ(giga.htmlToText("<p>Hello</p><p>World</p>"), "HelloWorld");
+    CHECK_EQ(giga.htmlToText("<p>Hello</p><p>World</p>", lines), "Hello\nWorld");
+    CHECK_EQ(giga.htmlToText("<div>a</div>b"), "ab");
+    CHECK_EQ(giga.htmlToText("<div>a</div>b", lines), "a\nb");
+    CHECK_EQ(giga.htmlToText("a<br>b"), "ab");
+    CHECK_EQ(giga.htmlToText("a<br>b", lines), "a\nb");
+    CHECK_EQ(giga.htmlToText("<title>T</title><p>para</p>"), "Tpara");
+    CHECK_EQ(giga.htmlToText("<script>x<y</script><svg><text>no</text></svg> &amp; <!-- c --> ok"), "& ok");
+    CHECK_EQ(giga.htmlToText("<p>a</p><iframe>hello</iframe>"), "ahello");
+    CHECK_EQ(giga.htmlToText("<noembed>fallback text</noembed>"), "fallback text");
+    CHECK_EQ(giga.htmlToText("a<SCRIPT>var x=1;</SCRIPT>b"), "avar x=1;b");
+    CHECK_EQ(giga.htmlToText("<xmp>code &amp; x</xmp>"), "code & x");
+
+    HtmlToTextOptions keep;
+    keep.entities = EntityMode::Keep;
+    keep.dropRawText = false;
+    CHECK_EQ(giga.htmlToText("<style>p{}</style>&amp;", keep), "p{}&amp;");
+
+    std::string buffer = "prefix:";
+    giga.htmlToText("<p> a  b </p>", buffer);
+    CHECK_EQ(buffer, "prefix:a b");
+
+    static const char *const pieces[] = {"<p>", "</p>", "<div class='a>b'>", "</div>", "text ", "more&amp;words", " \t ", "\n",
+                                         "&nbsp;", "&#10;", "<br>", "<!-- c -->", "<script>x<y</script>", "<style>p{}</style>",
+                                         "<svg><text>no</text></svg>", "\r", "&copy 2024", "<b>", "</b>", "&Tab;", "a", "  ",
+                                         "<li>", "&bogus;", "x &lt; y", "<title>T</title>", "<h1>", "</h1>",
+                                         "<iframe>hello</iframe>", "<noembed>fallback text</noembed>", "<SCRIPT>var x=1;</SCRIPT>",
+                                         "<xmp>code &amp; x</xmp>", "<noframes>no frames</noframes>", "<Style>q{}</Style>",
+                                         "<textarea>a &lt; b</textarea>"};
+    std::mt19937 random(25);
+    for (int i = 0; i < 20000; ++i)
+    {
+        std::string page;
+        for (size_t n = random() % 15; n > 0; --n)
+            page += pieces[random() % (sizeof(pieces) / sizeof(pieces[0]))];
+        CHECK_EQ(giga.htmlToText(page), chained(giga, page, false));
+        CHECK_EQ(giga.htmlToText(page, lines), chained(giga, page, true));
+    }
+}
+
+static void testHtmlToTextPages(GigaWeb &giga, const std::vector<CorpusPage> &pages)
+{
+    for (const CorpusPage &page : pages)
+    {
+        if (giga.htmlToText(page.html) != chained(giga, page.html, false))
+        {
+            ++checkFailures();
+            std::cerr << page.name << ": htmlToText differs from the chained calls" << std::endl;
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    GigaWeb giga;
+    testCleanTXT(giga);
+    testCleanHTML(giga);
+    testHtmlToText(giga);
+    testHtmlToTextPages(giga, loadCorpus(argc, argv));
+    return checkResult();
+}
@@ -0,0 +1,141 @@
+// GigaTokenizer: token boundaries on tricky markup, and a differential check
+// of the native path against Gumbo over the corpus (pass saved pages as
+// arguments to use them instead of the generated ones).
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include "GigaWeb.hpp"
+#include "check.hpp"
+#include "corpus.hpp"
+
+// Tokens as "S<p>", "E</p>", "T[text]", "C[comment]", "D" joined by spaces.
+static std::string tokens(std::string_view html)
+{
+    std::string out;
+    GigaTokenizer tokenizer(html);
+    HtmlToken token;
+    while (tokenizer.next(token))
+    {
+        if (!out.empty())
+            out += ' ';
+        switch (token.type)
+        {
+        case HtmlTokenType::StartTag:
+            out += "S" + std::string(token.text);
+            break;
+        case HtmlTokenType::EndTag:
+            out += "E" + std::string(token.text);
+            break;
+        case HtmlTokenType::Text:
+            out += "T[" + std::string(token.text) + "]";
+            break;
+        case HtmlTokenType::Comment:
+            out += "C[" + std::string(token.text) + "]";
+            break;
+        case HtmlTokenType::Doctype:
+            out += "D";
+            break;
+        }
+    }
+    return out;
+}
+
+// Text of every node outside noscript, one space between nodes and runs of
+// whitespace collapsed, so the result does not depend on how either parser
+// splits or places whitespace.
+static std::string textContent(const FlatDom &dom)
+{
+    std::string text;
+    for (uint32_t i = 0; i < dom.size();)
+    {
+        const DomNode &node = dom[i];
+        if (node.type == GUMBO_NODE_ELEMENT && node.tag == GUMBO_TAG_NOSCRIPT)
+        {
+            i = node.subtreeEnd;
+            continue;
+        }
+        if (node.type == GUMBO_NODE_TEXT || node.type == GUMBO_NODE_WHITESPACE || node.type == GUMBO_NODE_CDATA)
+        {
+            for (char c : dom.text(i))
+            {
+                bool space = c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f';
+                if (!space)
+                    text += c;
+                else if (!text.empty() && text.back() != ' ')
+                    text += ' ';
+            }
+            if (!text.empty() && text.back() != ' ')
+                text += ' ';
+        }
+        ++i;
+    }
+    if (!text.empty() && text.back() == ' ')
+        text.pop_back();
+    return text;
+}
+
+static void testTokens()
+{
+    CHECK_EQ(tokens("<p class=\"a>b\" id='c>d'>x</p>"), "S<p class=\"a>b\" id='c>d'> T[x] E</p>");
+    CHECK_EQ(tokens("<p title = \"a>b\">x"), "S<p title = \"a>b\"> T[x]");
+    CHECK_EQ(tokens("<p><img alt=Bob's>one</p><p>two</p>"), "S<p> S<img alt=Bob's> T[one] E</p> S<p> T[two] E</p>");
+    CHECK_EQ(tokens("<a b\"c>d</a>"), "S<a b\"c> T[d] E</a>");
+    CHECK_EQ(tokens("a<!-->b<p>c</p>"), "T[a] C[] T[b] S<p> T[c] E</p>");
+    CHECK_EQ(tokens("a<!--->b"), "T[a] C[] T[b]");
+    CHECK_EQ(tokens("a<!-- x > y -->b"), "T[a] C[ x > y ] T[b]");
+    CHECK_EQ(tokens("<![CDATA[x>y]]>z"), "C[x>y] T[z]");
+    CHECK_EQ(tokens("<!DOCTYPE html><?xml x?>a"), "D C[?xml x?] T[a]");
+    CHECK_EQ(tokens("<script>if (a<b) '</p>';</script>x"), "S<script> T[if (a<b) '</p>';] E</script> T[x]");
+    CHECK_EQ(tokens("<title>a<b>c</title>"), "S<title> T[a<b>c] E</title>");
+    CHECK_EQ(tokens("1 < 2 <3"), "T[1 ] T[< 2 ] T[<3]");
+}
+
+static void testFlatDom()
+{
+    FlatDom dom = GigaTokenizer::toFlatDom("<div><p>one<p>two &amp; three</div><p>four");
+    CHECK_EQ(textContent(dom), "one two & three four");
+
+    uint32_t div = dom[0].firstChild;
+    CHECK(div != DomNode::kNone && dom[div].tag == GUMBO_TAG_DIV);
+    CHECK_EQ(dom[div].subtreeEnd, 6u);
+}
+
+// Reports the first byte where the native result leaves Gumbo's.
+static void checkSame(const std::string &what, const std::string &native, const std::string &gumbo)
+{
+    if (native == gumbo)
+        return;
+    size_t at = static_cast<size_t>(std::mismatch(native.begin(), native.end(), gumbo.begin(), gumbo.end()).first - native.begin());
+    size_t from = at > 30 ? at - 30 : 0;
+    ++checkFailures();
+    std::cerr << what << ": differs from Gumbo at byte " << at << "\n  native: " << native.substr(from, 80)
+              << "\n  gumbo:  " << gumbo.substr(from, 80) << std::endl;
+}
+
+static void testAgainstGumbo(const std::vector<CorpusPage> &pages)
+{
+    GigaWeb giga;
+    for (const CorpusPage &page : pages)
+    {
+        GigaWeb::Document document(page.html);
+        checkSame(page.name + " text", textContent(GigaTokenizer::toFlatDom(page.html)), textContent(document.dom()));
+
+        giga.setHtmlParser(HtmlParser::Native);
+        std::string mainNative = giga.getMainContent(page.html);
+        std::vector<std::string> multipleNative = giga.getMultipleContents(page.html);
+        giga.setHtmlParser(HtmlParser::Gumbo);
+        std::vector<std::string> multipleGumbo = giga.getMultipleContents(page.html);
+        checkSame(page.name + " getMainContent", mainNative, giga.getMainContent(page.html));
+        CHECK_EQ(multipleNative.size(), multipleGumbo.size());
+        for (size_t i = 0; i < multipleNative.size() && i < multipleGumbo.size(); ++i)
+            checkSame(page.name + " getMultipleContents[" + std::to_string(i) + "]", multipleNative[i], multipleGumbo[i]);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    testTokens();
+    testFlatDom();
+    testAgainstGumbo(loadCorpus(argc, argv));
+    return checkResult();
+}
@@ -0,0 +1,68 @@
+// The walkers are iterative: deeply nested pages must work on a thread with
+// a small stack, as in the crawler's workers.
+#include <pthread.h>
+#include <string>
+#include "GigaWeb.hpp"
+#include "check.hpp"
+#include "corpus.hpp"
+
+static const std::string kDeepest = "the deepest paragraph holds the longest text";
+
+static void deepNative()
+{
+    GigaWeb giga;
+    giga.setHtmlParser(HtmlParser::Native);
+    std::string html = deepPage(100000);
+    CHECK(giga.getMainContent(html).find(kDeepest) != std::string::npos);
+    std::vector<std::string> contents = giga.getMultipleContents(html);
+    CHECK(!contents.empty() && contents.back().find(kDeepest) == 0);
+
+    FlatDom dom = GigaTokenizer::toFlatDom(html);
+    CHECK_EQ(GigaSelector("div > a").select(dom).size(), 50000u);
+
+    // Descendant combinators must not search the ancestors of every node:
+    // on this page that is quadratic in the depth and takes hours, above all
+    // when the selector fails.
+    CHECK(GigaSelector("section div div").select(dom).empty());
+    CHECK(GigaSelector("section span, article a").select(dom).empty());
+    std::vector<uint32_t> found = GigaSelector("div span a").select(dom);
+    CHECK_EQ(found.size(), 49999u);
+    CHECK(!found.empty() && GigaSelector("body div span a").matches(dom, found.back()));
+    GigaSelectorSet set;
+    set.add("section div div");
+    set.add("span > div > a");
+    std::vector<std::vector<uint32_t>> matched = set.select(dom);
+    CHECK(matched[0].empty());
+    CHECK_EQ(matched[1].size(), 49999u);
+}
+
+// Gumbo's own tree construction is quadratic in the depth, so its page is
+// shallower; the point is that nothing here recurses per level.
+static void deepGumbo()
+{
+    GigaWeb::Document document(deepPage(10000));
+    document.mainContent();
+    document.multipleContents();
+    document.links();
+    document.textContents("p");
+    document.select("span span");
+}
+
+static void *runChecks(void *)
+{
+    deepNative();
+    deepGumbo();
+    return nullptr;
+}
+
+int main()
+{
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, 256 * 1024);
+    pthread_t thread;
+    CHECK(pthread_create(&thread, &attr, runChecks, nullptr) == 0);
+    pthread_join(thread, nullptr);
+    pthread_attr_destroy(&attr);
+    return checkResult();
+}